@@ -0,0 +1,296 @@
+/*
+ * Benchmarks for the parse, dump and access hot paths.
+ *
+ * Each benchmark runs on a synthetic corpus that is generated here, so results are
+ * reproducible without any data files:
+ *
+ *   canada   - arrays of coordinate pairs, almost all doubles (like canada.json)
+ *   twitter  - statuses with long strings, escapes, non-ASCII text and nested objects
+ *   deep     - arrays and objects nested close to the parser's depth limit
+ *   ndjson   - many small newline-delimited objects
+ *
+ * Results are printed one JSON object per line, for example
+ *
+ *   {"allocs_per_doc": 1437, "benchmark": "parse", "bytes": 2161766, "corpus": "canada", ...}
+ *
+ * so that runs can be saved and compared between releases. Arguments that do not start
+ * with "--" select benchmarks whose "benchmark/corpus" name contains one of them, and
+ * --min-time=SECONDS sets how long each one runs (0.5 by default). Build with
+ * -DCMAKE_BUILD_TYPE=Release for meaningful numbers.
+ */
+
+#include "json11.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace json11;
+using std::string;
+using std::vector;
+
+/* * * * * * * * * * * * * * * * * * * *
+ * Allocation counting
+ */
+
+static std::atomic<size_t> allocations(0);
+
+void * operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    std::free(p);
+}
+
+/* * * * * * * * * * * * * * * * * * * *
+ * Corpus
+ */
+
+// A fixed linear congruential generator, so every run sees the same corpus.
+struct Random {
+    unsigned long long state = 88172645463325252ull;
+    unsigned next() {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        return static_cast<unsigned>(state >> 33);
+    }
+    double uniform(double lo, double hi) { return lo + (hi - lo) * (next() / 2147483648.0); }
+};
+
+static string canada_corpus() {
+    Random random;
+    Json::array polygons;
+    for (int p = 0; p < 40; p++) {
+        Json::array ring;
+        for (int i = 0; i < 1000; i++)
+            ring.push_back(Json::array { random.uniform(-141.0, -52.0), random.uniform(41.0, 84.0) });
+        polygons.push_back(Json::array { ring });
+    }
+    return Json(Json::object {
+        { "type", "FeatureCollection" },
+        { "features", Json::array { Json::object {
+            { "type", "Feature" },
+            { "properties", Json::object { { "name", "Canada" } } },
+            { "geometry", Json::object { { "type", "Polygon" }, { "coordinates", polygons } } },
+        } } },
+    }).dump();
+}
+
+static string twitter_corpus() {
+    Random random;
+    const char *words[] = { "json", "parser", "fast", "\xe3\x83\x86\xe3\x82\xb9\xe3\x83\x88",
+                            "caf\xc3\xa9", "\"quoted\"", "line\nbreak", "tab\there", "benchmark" };
+    Json::array statuses;
+    for (int i = 0; i < 2000; i++) {
+        string text;
+        for (int w = 0; w < 20; w++) {
+            text += words[random.next() % (sizeof words / sizeof *words)];
+            text += ' ';
+        }
+        statuses.push_back(Json::object {
+            { "id", static_cast<int>(random.next() & 0x7fffffff) },
+            { "text", text },
+            { "truncated", false },
+            { "retweet_count", static_cast<int>(random.next() % 1000) },
+            { "favorited", random.next() % 2 == 0 },
+            { "in_reply_to_screen_name", nullptr },
+            { "entities", Json::object {
+                { "hashtags", Json::array { "json", "cpp" } },
+                { "urls", Json::array { "https://example.com/" + std::to_string(i) } },
+            } },
+            { "user", Json::object {
+                { "id", static_cast<int>(random.next() & 0x7fffffff) },
+                { "screen_name", "user" + std::to_string(i) },
+                { "description", text.substr(0, 60) },
+                { "followers_count", static_cast<int>(random.next() % 100000) },
+                { "verified", false },
+            } },
+        });
+    }
+    return Json(Json::object { { "statuses", statuses } }).dump();
+}
+
+static string deep_corpus() {
+    Json::array docs;
+    for (int d = 0; d < 200; d++) {
+        Json value = d;
+        for (int level = 0; level < 150; level++) {
+            if (level % 2)
+                value = Json::array { value, level };
+            else
+                value = Json::object { { "level", level }, { "child", value } };
+        }
+        docs.push_back(value);
+    }
+    return Json(docs).dump();
+}
+
+static string ndjson_corpus() {
+    Random random;
+    string out;
+    for (int i = 0; i < 50000; i++) {
+        out += Json(Json::object {
+            { "seq", i },
+            { "event", i % 3 ? "click" : "view" },
+            { "value", random.uniform(0, 1000) },
+            { "tags", Json::array { "a", "b" } },
+        }).dump();
+        out += '\n';
+    }
+    return out;
+}
+
+/* * * * * * * * * * * * * * * * * * * *
+ * Running
+ */
+
+// A benchmark that handles one document. Its results are summed into sink, so they are not
+// optimized out.
+static volatile size_t sink;
+typedef size_t (*BenchFunction)(const string &input, const Json &parsed);
+
+struct Benchmark {
+    const char *name;
+    const char *corpus;
+    BenchFunction run;
+};
+
+static size_t bench_parse(const string &input, const Json &) {
+    string err;
+    const Json json = Json::parse(input, err);
+    return err.size() + json.is_null();
+}
+
+static size_t bench_parse_multi(const string &input, const Json &) {
+    string err;
+    return Json::parse_multi(input, err).size() + err.size();
+}
+
+static size_t bench_dump(const string &, const Json &parsed) {
+    string out;
+    parsed.dump(out);
+    return out.size();
+}
+
+static size_t bench_as_coordinates(const string &, const Json &parsed) {
+    typedef vector<vector<vector<double>>> Polygon;
+    const Json &coordinates = parsed["features"][0]["geometry"]["coordinates"];
+    return coordinates.as<Polygon>().size();
+}
+
+static size_t bench_index_statuses(const string &, const Json &parsed) {
+    size_t total = 0;
+    const Json &statuses = parsed["statuses"];
+    for (size_t i = 0; i < statuses.array_items().size(); i++) {
+        const Json &status = statuses[i];
+        total += status["retweet_count"].int_value() + status["user"]["followers_count"].int_value();
+        total += status["text"].string_value().size() + status["favorited"].bool_value();
+    }
+    return total;
+}
+
+static size_t bench_as_events(const string &, const Json &parsed) {
+    size_t total = 0;
+    for (const Json &line : parsed.array_items())
+        total += line["seq"].as<int>() + line["event"].as<string>().size();
+    return total;
+}
+
+static const Benchmark benchmarks[] = {
+    { "parse",       "canada",  bench_parse },
+    { "dump",        "canada",  bench_dump },
+    { "as",          "canada",  bench_as_coordinates },
+    { "parse",       "twitter", bench_parse },
+    { "dump",        "twitter", bench_dump },
+    { "index",       "twitter", bench_index_statuses },
+    { "parse",       "deep",    bench_parse },
+    { "dump",        "deep",    bench_dump },
+    { "parse_multi", "ndjson",  bench_parse_multi },
+    { "as",          "ndjson",  bench_as_events },
+};
+
+static bool selected(const string &name, const vector<string> &filters) {
+    if (filters.empty())
+        return true;
+    for (const string &filter : filters)
+        if (name.find(filter) != string::npos)
+            return true;
+    return false;
+}
+
+int main(int argc, char **argv) {
+    double min_time = 0.5;
+    vector<string> filters;
+    for (int i = 1; i < argc; i++) {
+        if (std::strncmp(argv[i], "--min-time=", 11) == 0)
+            min_time = std::atof(argv[i] + 11);
+        else
+            filters.push_back(argv[i]);
+    }
+
+    struct Corpus { const char *name; string text; Json parsed; };
+    vector<Corpus> corpora;
+    for (const char *name : { "canada", "twitter", "deep", "ndjson" }) {
+        const string text = !std::strcmp(name, "canada")  ? canada_corpus()
+                          : !std::strcmp(name, "twitter") ? twitter_corpus()
+                          : !std::strcmp(name, "deep")    ? deep_corpus()
+                          :                                 ndjson_corpus();
+        string err;
+        // The access benchmarks read NDJSON as the array of its lines.
+        const Json parsed = !std::strcmp(name, "ndjson") ? Json(Json::parse_multi(text, err))
+                                                         : Json::parse(text, err);
+        if (!err.empty()) {
+            std::fprintf(stderr, "bad %s corpus: %s\n", name, err.c_str());
+            return 1;
+        }
+        corpora.push_back(Corpus { name, text, parsed });
+    }
+
+    for (const Benchmark &bench : benchmarks) {
+        if (!selected(string(bench.name) + "/" + bench.corpus, filters))
+            continue;
+        const Corpus *corpus = nullptr;
+        for (const Corpus &c : corpora)
+            if (!std::strcmp(c.name, bench.corpus))
+                corpus = &c;
+
+        // One untimed run to warm up caches and the allocator.
+        sink += bench.run(corpus->text, corpus->parsed);
+
+        typedef std::chrono::steady_clock clock;
+        const size_t allocs_before = allocations.load(std::memory_order_relaxed);
+        const clock::time_point start = clock::now();
+        size_t iterations = 0;
+        double seconds = 0;
+        do {
+            sink += bench.run(corpus->text, corpus->parsed);
+            iterations++;
+            seconds = std::chrono::duration<double>(clock::now() - start).count();
+        } while (seconds < min_time);
+        const size_t allocs = allocations.load(std::memory_order_relaxed) - allocs_before;
+
+        const double bytes = static_cast<double>(corpus->text.size());
+        std::printf("%s\n", Json(Json::object {
+            { "benchmark", bench.name },
+            { "corpus", bench.corpus },
+            { "bytes", bytes },
+            { "iterations", static_cast<double>(iterations) },
+            { "seconds", seconds },
+            { "mb_per_s", bytes * iterations / seconds / 1e6 },
+            { "allocs_per_doc", static_cast<double>(allocs) / iterations },
+        }).dump().c_str());
+        std::fflush(stdout);
+    }
+    return 0;
+}
@@ -21,10 +21,33 @@
 
 #include "json11.hpp"
 #include <cassert>
+#include <clocale>
 #include <cmath>
 #include <cstdlib>
 #include <cstdio>
 #include <limits>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <new>
+#include <condition_variable>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define JSON11_USE_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define JSON11_USE_NEON 1
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 namespace json11 {
 
@@ -32,89 +55,1464 @@ static const int max_depth = 200;
 
 using std::string;
 using std::vector;
-using std::map;
 using std::make_shared;
 using std::initializer_list;
 using std::move;
 
+
+/* * * * * * * * * * * * * * * * * * * *
+ * Number conversion
+ *
+ * Decimal <-> binary conversion for doubles, independent of the C locale. Parsing uses
+ * Clinger's exact fast path, then the Eisel-Lemire algorithm, and only falls back to strtod
+ * for the rare inputs neither can decide. Formatting uses Grisu2, which produces the
+ * shortest (or, very rarely, a slightly longer) digit string that round-trips.
+ */
+
+/* 128-bit significands of the powers of ten from 1e-348 to 1e347, normalized so that the top
+ * bit is set and truncated toward zero. 10^q lies in [2^b, 2^(b+1)) for b = (q * 217706) >> 16.
+ */
+static const int pow10_min_exponent = -348;
+static const int pow10_max_exponent = 347;
+static const uint64_t pow10_significands[][2] = {
+    { 0xfa8fd5a0081c0288, 0x1732c869cd60e453 }, // 1e-348
+    { 0x9c99e58405118195, 0x0e7fbd42205c8eb4 }, // 1e-347
+    { 0xc3c05ee50655e1fa, 0x521fac92a873b261 }, // 1e-346
+    { 0xf4b0769e47eb5a78, 0xe6a797b752909ef9 }, // 1e-345
+    { 0x98ee4a22ecf3188b, 0x9028bed2939a635c }, // 1e-344
+    { 0xbf29dcaba82fdeae, 0x7432ee873880fc33 }, // 1e-343
+    { 0xeef453d6923bd65a, 0x113faa2906a13b3f }, // 1e-342
+    { 0x9558b4661b6565f8, 0x4ac7ca59a424c507 }, // 1e-341
+    { 0xbaaee17fa23ebf76, 0x5d79bcf00d2df649 }, // 1e-340
+    { 0xe95a99df8ace6f53, 0xf4d82c2c107973dc }, // 1e-339
+    { 0x91d8a02bb6c10594, 0x79071b9b8a4be869 }, // 1e-338
+    { 0xb64ec836a47146f9, 0x9748e2826cdee284 }, // 1e-337
+    { 0xe3e27a444d8d98b7, 0xfd1b1b2308169b25 }, // 1e-336
+    { 0x8e6d8c6ab0787f72, 0xfe30f0f5e50e20f7 }, // 1e-335
+    { 0xb208ef855c969f4f, 0xbdbd2d335e51a935 }, // 1e-334
+    { 0xde8b2b66b3bc4723, 0xad2c788035e61382 }, // 1e-333
+    { 0x8b16fb203055ac76, 0x4c3bcb5021afcc31 }, // 1e-332
+    { 0xaddcb9e83c6b1793, 0xdf4abe242a1bbf3d }, // 1e-331
+    { 0xd953e8624b85dd78, 0xd71d6dad34a2af0d }, // 1e-330
+    { 0x87d4713d6f33aa6b, 0x8672648c40e5ad68 }, // 1e-329
+    { 0xa9c98d8ccb009506, 0x680efdaf511f18c2 }, // 1e-328
+    { 0xd43bf0effdc0ba48, 0x0212bd1b2566def2 }, // 1e-327
+    { 0x84a57695fe98746d, 0x014bb630f7604b57 }, // 1e-326
+    { 0xa5ced43b7e3e9188, 0x419ea3bd35385e2d }, // 1e-325
+    { 0xcf42894a5dce35ea, 0x52064cac828675b9 }, // 1e-324
+    { 0x818995ce7aa0e1b2, 0x7343efebd1940993 }, // 1e-323
+    { 0xa1ebfb4219491a1f, 0x1014ebe6c5f90bf8 }, // 1e-322
+    { 0xca66fa129f9b60a6, 0xd41a26e077774ef6 }, // 1e-321
+    { 0xfd00b897478238d0, 0x8920b098955522b4 }, // 1e-320
+    { 0x9e20735e8cb16382, 0x55b46e5f5d5535b0 }, // 1e-319
+    { 0xc5a890362fddbc62, 0xeb2189f734aa831d }, // 1e-318
+    { 0xf712b443bbd52b7b, 0xa5e9ec7501d523e4 }, // 1e-317
+    { 0x9a6bb0aa55653b2d, 0x47b233c92125366e }, // 1e-316
+    { 0xc1069cd4eabe89f8, 0x999ec0bb696e840a }, // 1e-315
+    { 0xf148440a256e2c76, 0xc00670ea43ca250d }, // 1e-314
+    { 0x96cd2a865764dbca, 0x380406926a5e5728 }, // 1e-313
+    { 0xbc807527ed3e12bc, 0xc605083704f5ecf2 }, // 1e-312
+    { 0xeba09271e88d976b, 0xf7864a44c633682e }, // 1e-311
+    { 0x93445b8731587ea3, 0x7ab3ee6afbe0211d }, // 1e-310
+    { 0xb8157268fdae9e4c, 0x5960ea05bad82964 }, // 1e-309
+    { 0xe61acf033d1a45df, 0x6fb92487298e33bd }, // 1e-308
+    { 0x8fd0c16206306bab, 0xa5d3b6d479f8e056 }, // 1e-307
+    { 0xb3c4f1ba87bc8696, 0x8f48a4899877186c }, // 1e-306
+    { 0xe0b62e2929aba83c, 0x331acdabfe94de87 }, // 1e-305
+    { 0x8c71dcd9ba0b4925, 0x9ff0c08b7f1d0b14 }, // 1e-304
+    { 0xaf8e5410288e1b6f, 0x07ecf0ae5ee44dd9 }, // 1e-303
+    { 0xdb71e91432b1a24a, 0xc9e82cd9f69d6150 }, // 1e-302
+    { 0x892731ac9faf056e, 0xbe311c083a225cd2 }, // 1e-301
+    { 0xab70fe17c79ac6ca, 0x6dbd630a48aaf406 }, // 1e-300
+    { 0xd64d3d9db981787d, 0x092cbbccdad5b108 }, // 1e-299
+    { 0x85f0468293f0eb4e, 0x25bbf56008c58ea5 }, // 1e-298
+    { 0xa76c582338ed2621, 0xaf2af2b80af6f24e }, // 1e-297
+    { 0xd1476e2c07286faa, 0x1af5af660db4aee1 }, // 1e-296
+    { 0x82cca4db847945ca, 0x50d98d9fc890ed4d }, // 1e-295
+    { 0xa37fce126597973c, 0xe50ff107bab528a0 }, // 1e-294
+    { 0xcc5fc196fefd7d0c, 0x1e53ed49a96272c8 }, // 1e-293
+    { 0xff77b1fcbebcdc4f, 0x25e8e89c13bb0f7a }, // 1e-292
+    { 0x9faacf3df73609b1, 0x77b191618c54e9ac }, // 1e-291
+    { 0xc795830d75038c1d, 0xd59df5b9ef6a2417 }, // 1e-290
+    { 0xf97ae3d0d2446f25, 0x4b0573286b44ad1d }, // 1e-289
+    { 0x9becce62836ac577, 0x4ee367f9430aec32 }, // 1e-288
+    { 0xc2e801fb244576d5, 0x229c41f793cda73f }, // 1e-287
+    { 0xf3a20279ed56d48a, 0x6b43527578c1110f }, // 1e-286
+    { 0x9845418c345644d6, 0x830a13896b78aaa9 }, // 1e-285
+    { 0xbe5691ef416bd60c, 0x23cc986bc656d553 }, // 1e-284
+    { 0xedec366b11c6cb8f, 0x2cbfbe86b7ec8aa8 }, // 1e-283
+    { 0x94b3a202eb1c3f39, 0x7bf7d71432f3d6a9 }, // 1e-282
+    { 0xb9e08a83a5e34f07, 0xdaf5ccd93fb0cc53 }, // 1e-281
+    { 0xe858ad248f5c22c9, 0xd1b3400f8f9cff68 }, // 1e-280
+    { 0x91376c36d99995be, 0x23100809b9c21fa1 }, // 1e-279
+    { 0xb58547448ffffb2d, 0xabd40a0c2832a78a }, // 1e-278
+    { 0xe2e69915b3fff9f9, 0x16c90c8f323f516c }, // 1e-277
+    { 0x8dd01fad907ffc3b, 0xae3da7d97f6792e3 }, // 1e-276
+    { 0xb1442798f49ffb4a, 0x99cd11cfdf41779c }, // 1e-275
+    { 0xdd95317f31c7fa1d, 0x40405643d711d583 }, // 1e-274
+    { 0x8a7d3eef7f1cfc52, 0x482835ea666b2572 }, // 1e-273
+    { 0xad1c8eab5ee43b66, 0xda3243650005eecf }, // 1e-272
+    { 0xd863b256369d4a40, 0x90bed43e40076a82 }, // 1e-271
+    { 0x873e4f75e2224e68, 0x5a7744a6e804a291 }, // 1e-270
+    { 0xa90de3535aaae202, 0x711515d0a205cb36 }, // 1e-269
+    { 0xd3515c2831559a83, 0x0d5a5b44ca873e03 }, // 1e-268
+    { 0x8412d9991ed58091, 0xe858790afe9486c2 }, // 1e-267
+    { 0xa5178fff668ae0b6, 0x626e974dbe39a872 }, // 1e-266
+    { 0xce5d73ff402d98e3, 0xfb0a3d212dc8128f }, // 1e-265
+    { 0x80fa687f881c7f8e, 0x7ce66634bc9d0b99 }, // 1e-264
+    { 0xa139029f6a239f72, 0x1c1fffc1ebc44e80 }, // 1e-263
+    { 0xc987434744ac874e, 0xa327ffb266b56220 }, // 1e-262
+    { 0xfbe9141915d7a922, 0x4bf1ff9f0062baa8 }, // 1e-261
+    { 0x9d71ac8fada6c9b5, 0x6f773fc3603db4a9 }, // 1e-260
+    { 0xc4ce17b399107c22, 0xcb550fb4384d21d3 }, // 1e-259
+    { 0xf6019da07f549b2b, 0x7e2a53a146606a48 }, // 1e-258
+    { 0x99c102844f94e0fb, 0x2eda7444cbfc426d }, // 1e-257
+    { 0xc0314325637a1939, 0xfa911155fefb5308 }, // 1e-256
+    { 0xf03d93eebc589f88, 0x793555ab7eba27ca }, // 1e-255
+    { 0x96267c7535b763b5, 0x4bc1558b2f3458de }, // 1e-254
+    { 0xbbb01b9283253ca2, 0x9eb1aaedfb016f16 }, // 1e-253
+    { 0xea9c227723ee8bcb, 0x465e15a979c1cadc }, // 1e-252
+    { 0x92a1958a7675175f, 0x0bfacd89ec191ec9 }, // 1e-251
+    { 0xb749faed14125d36, 0xcef980ec671f667b }, // 1e-250
+    { 0xe51c79a85916f484, 0x82b7e12780e7401a }, // 1e-249
+    { 0x8f31cc0937ae58d2, 0xd1b2ecb8b0908810 }, // 1e-248
+    { 0xb2fe3f0b8599ef07, 0x861fa7e6dcb4aa15 }, // 1e-247
+    { 0xdfbdcece67006ac9, 0x67a791e093e1d49a }, // 1e-246
+    { 0x8bd6a141006042bd, 0xe0c8bb2c5c6d24e0 }, // 1e-245
+    { 0xaecc49914078536d, 0x58fae9f773886e18 }, // 1e-244
+    { 0xda7f5bf590966848, 0xaf39a475506a899e }, // 1e-243
+    { 0x888f99797a5e012d, 0x6d8406c952429603 }, // 1e-242
+    { 0xaab37fd7d8f58178, 0xc8e5087ba6d33b83 }, // 1e-241
+    { 0xd5605fcdcf32e1d6, 0xfb1e4a9a90880a64 }, // 1e-240
+    { 0x855c3be0a17fcd26, 0x5cf2eea09a55067f }, // 1e-239
+    { 0xa6b34ad8c9dfc06f, 0xf42faa48c0ea481e }, // 1e-238
+    { 0xd0601d8efc57b08b, 0xf13b94daf124da26 }, // 1e-237
+    { 0x823c12795db6ce57, 0x76c53d08d6b70858 }, // 1e-236
+    { 0xa2cb1717b52481ed, 0x54768c4b0c64ca6e }, // 1e-235
+    { 0xcb7ddcdda26da268, 0xa9942f5dcf7dfd09 }, // 1e-234
+    { 0xfe5d54150b090b02, 0xd3f93b35435d7c4c }, // 1e-233
+    { 0x9efa548d26e5a6e1, 0xc47bc5014a1a6daf }, // 1e-232
+    { 0xc6b8e9b0709f109a, 0x359ab6419ca1091b }, // 1e-231
+    { 0xf867241c8cc6d4c0, 0xc30163d203c94b62 }, // 1e-230
+    { 0x9b407691d7fc44f8, 0x79e0de63425dcf1d }, // 1e-229
+    { 0xc21094364dfb5636, 0x985915fc12f542e4 }, // 1e-228
+    { 0xf294b943e17a2bc4, 0x3e6f5b7b17b2939d }, // 1e-227
+    { 0x979cf3ca6cec5b5a, 0xa705992ceecf9c42 }, // 1e-226
+    { 0xbd8430bd08277231, 0x50c6ff782a838353 }, // 1e-225
+    { 0xece53cec4a314ebd, 0xa4f8bf5635246428 }, // 1e-224
+    { 0x940f4613ae5ed136, 0x871b7795e136be99 }, // 1e-223
+    { 0xb913179899f68584, 0x28e2557b59846e3f }, // 1e-222
+    { 0xe757dd7ec07426e5, 0x331aeada2fe589cf }, // 1e-221
+    { 0x9096ea6f3848984f, 0x3ff0d2c85def7621 }, // 1e-220
+    { 0xb4bca50b065abe63, 0x0fed077a756b53a9 }, // 1e-219
+    { 0xe1ebce4dc7f16dfb, 0xd3e8495912c62894 }, // 1e-218
+    { 0x8d3360f09cf6e4bd, 0x64712dd7abbbd95c }, // 1e-217
+    { 0xb080392cc4349dec, 0xbd8d794d96aacfb3 }, // 1e-216
+    { 0xdca04777f541c567, 0xecf0d7a0fc5583a0 }, // 1e-215
+    { 0x89e42caaf9491b60, 0xf41686c49db57244 }, // 1e-214
+    { 0xac5d37d5b79b6239, 0x311c2875c522ced5 }, // 1e-213
+    { 0xd77485cb25823ac7, 0x7d633293366b828b }, // 1e-212
+    { 0x86a8d39ef77164bc, 0xae5dff9c02033197 }, // 1e-211
+    { 0xa8530886b54dbdeb, 0xd9f57f830283fdfc }, // 1e-210
+    { 0xd267caa862a12d66, 0xd072df63c324fd7b }, // 1e-209
+    { 0x8380dea93da4bc60, 0x4247cb9e59f71e6d }, // 1e-208
+    { 0xa46116538d0deb78, 0x52d9be85f074e608 }, // 1e-207
+    { 0xcd795be870516656, 0x67902e276c921f8b }, // 1e-206
+    { 0x806bd9714632dff6, 0x00ba1cd8a3db53b6 }, // 1e-205
+    { 0xa086cfcd97bf97f3, 0x80e8a40eccd228a4 }, // 1e-204
+    { 0xc8a883c0fdaf7df0, 0x6122cd128006b2cd }, // 1e-203
+    { 0xfad2a4b13d1b5d6c, 0x796b805720085f81 }, // 1e-202
+    { 0x9cc3a6eec6311a63, 0xcbe3303674053bb0 }, // 1e-201
+    { 0xc3f490aa77bd60fc, 0xbedbfc4411068a9c }, // 1e-200
+    { 0xf4f1b4d515acb93b, 0xee92fb5515482d44 }, // 1e-199
+    { 0x991711052d8bf3c5, 0x751bdd152d4d1c4a }, // 1e-198
+    { 0xbf5cd54678eef0b6, 0xd262d45a78a0635d }, // 1e-197
+    { 0xef340a98172aace4, 0x86fb897116c87c34 }, // 1e-196
+    { 0x9580869f0e7aac0e, 0xd45d35e6ae3d4da0 }, // 1e-195
+    { 0xbae0a846d2195712, 0x8974836059cca109 }, // 1e-194
+    { 0xe998d258869facd7, 0x2bd1a438703fc94b }, // 1e-193
+    { 0x91ff83775423cc06, 0x7b6306a34627ddcf }, // 1e-192
+    { 0xb67f6455292cbf08, 0x1a3bc84c17b1d542 }, // 1e-191
+    { 0xe41f3d6a7377eeca, 0x20caba5f1d9e4a93 }, // 1e-190
+    { 0x8e938662882af53e, 0x547eb47b7282ee9c }, // 1e-189
+    { 0xb23867fb2a35b28d, 0xe99e619a4f23aa43 }, // 1e-188
+    { 0xdec681f9f4c31f31, 0x6405fa00e2ec94d4 }, // 1e-187
+    { 0x8b3c113c38f9f37e, 0xde83bc408dd3dd04 }, // 1e-186
+    { 0xae0b158b4738705e, 0x9624ab50b148d445 }, // 1e-185
+    { 0xd98ddaee19068c76, 0x3badd624dd9b0957 }, // 1e-184
+    { 0x87f8a8d4cfa417c9, 0xe54ca5d70a80e5d6 }, // 1e-183
+    { 0xa9f6d30a038d1dbc, 0x5e9fcf4ccd211f4c }, // 1e-182
+    { 0xd47487cc8470652b, 0x7647c3200069671f }, // 1e-181
+    { 0x84c8d4dfd2c63f3b, 0x29ecd9f40041e073 }, // 1e-180
+    { 0xa5fb0a17c777cf09, 0xf468107100525890 }, // 1e-179
+    { 0xcf79cc9db955c2cc, 0x7182148d4066eeb4 }, // 1e-178
+    { 0x81ac1fe293d599bf, 0xc6f14cd848405530 }, // 1e-177
+    { 0xa21727db38cb002f, 0xb8ada00e5a506a7c }, // 1e-176
+    { 0xca9cf1d206fdc03b, 0xa6d90811f0e4851c }, // 1e-175
+    { 0xfd442e4688bd304a, 0x908f4a166d1da663 }, // 1e-174
+    { 0x9e4a9cec15763e2e, 0x9a598e4e043287fe }, // 1e-173
+    { 0xc5dd44271ad3cdba, 0x40eff1e1853f29fd }, // 1e-172
+    { 0xf7549530e188c128, 0xd12bee59e68ef47c }, // 1e-171
+    { 0x9a94dd3e8cf578b9, 0x82bb74f8301958ce }, // 1e-170
+    { 0xc13a148e3032d6e7, 0xe36a52363c1faf01 }, // 1e-169
+    { 0xf18899b1bc3f8ca1, 0xdc44e6c3cb279ac1 }, // 1e-168
+    { 0x96f5600f15a7b7e5, 0x29ab103a5ef8c0b9 }, // 1e-167
+    { 0xbcb2b812db11a5de, 0x7415d448f6b6f0e7 }, // 1e-166
+    { 0xebdf661791d60f56, 0x111b495b3464ad21 }, // 1e-165
+    { 0x936b9fcebb25c995, 0xcab10dd900beec34 }, // 1e-164
+    { 0xb84687c269ef3bfb, 0x3d5d514f40eea742 }, // 1e-163
+    { 0xe65829b3046b0afa, 0x0cb4a5a3112a5112 }, // 1e-162
+    { 0x8ff71a0fe2c2e6dc, 0x47f0e785eaba72ab }, // 1e-161
+    { 0xb3f4e093db73a093, 0x59ed216765690f56 }, // 1e-160
+    { 0xe0f218b8d25088b8, 0x306869c13ec3532c }, // 1e-159
+    { 0x8c974f7383725573, 0x1e414218c73a13fb }, // 1e-158
+    { 0xafbd2350644eeacf, 0xe5d1929ef90898fa }, // 1e-157
+    { 0xdbac6c247d62a583, 0xdf45f746b74abf39 }, // 1e-156
+    { 0x894bc396ce5da772, 0x6b8bba8c328eb783 }, // 1e-155
+    { 0xab9eb47c81f5114f, 0x066ea92f3f326564 }, // 1e-154
+    { 0xd686619ba27255a2, 0xc80a537b0efefebd }, // 1e-153
+    { 0x8613fd0145877585, 0xbd06742ce95f5f36 }, // 1e-152
+    { 0xa798fc4196e952e7, 0x2c48113823b73704 }, // 1e-151
+    { 0xd17f3b51fca3a7a0, 0xf75a15862ca504c5 }, // 1e-150
+    { 0x82ef85133de648c4, 0x9a984d73dbe722fb }, // 1e-149
+    { 0xa3ab66580d5fdaf5, 0xc13e60d0d2e0ebba }, // 1e-148
+    { 0xcc963fee10b7d1b3, 0x318df905079926a8 }, // 1e-147
+    { 0xffbbcfe994e5c61f, 0xfdf17746497f7052 }, // 1e-146
+    { 0x9fd561f1fd0f9bd3, 0xfeb6ea8bedefa633 }, // 1e-145
+    { 0xc7caba6e7c5382c8, 0xfe64a52ee96b8fc0 }, // 1e-144
+    { 0xf9bd690a1b68637b, 0x3dfdce7aa3c673b0 }, // 1e-143
+    { 0x9c1661a651213e2d, 0x06bea10ca65c084e }, // 1e-142
+    { 0xc31bfa0fe5698db8, 0x486e494fcff30a62 }, // 1e-141
+    { 0xf3e2f893dec3f126, 0x5a89dba3c3efccfa }, // 1e-140
+    { 0x986ddb5c6b3a76b7, 0xf89629465a75e01c }, // 1e-139
+    { 0xbe89523386091465, 0xf6bbb397f1135823 }, // 1e-138
+    { 0xee2ba6c0678b597f, 0x746aa07ded582e2c }, // 1e-137
+    { 0x94db483840b717ef, 0xa8c2a44eb4571cdc }, // 1e-136
+    { 0xba121a4650e4ddeb, 0x92f34d62616ce413 }, // 1e-135
+    { 0xe896a0d7e51e1566, 0x77b020baf9c81d17 }, // 1e-134
+    { 0x915e2486ef32cd60, 0x0ace1474dc1d122e }, // 1e-133
+    { 0xb5b5ada8aaff80b8, 0x0d819992132456ba }, // 1e-132
+    { 0xe3231912d5bf60e6, 0x10e1fff697ed6c69 }, // 1e-131
+    { 0x8df5efabc5979c8f, 0xca8d3ffa1ef463c1 }, // 1e-130
+    { 0xb1736b96b6fd83b3, 0xbd308ff8a6b17cb2 }, // 1e-129
+    { 0xddd0467c64bce4a0, 0xac7cb3f6d05ddbde }, // 1e-128
+    { 0x8aa22c0dbef60ee4, 0x6bcdf07a423aa96b }, // 1e-127
+    { 0xad4ab7112eb3929d, 0x86c16c98d2c953c6 }, // 1e-126
+    { 0xd89d64d57a607744, 0xe871c7bf077ba8b7 }, // 1e-125
+    { 0x87625f056c7c4a8b, 0x11471cd764ad4972 }, // 1e-124
+    { 0xa93af6c6c79b5d2d, 0xd598e40d3dd89bcf }, // 1e-123
+    { 0xd389b47879823479, 0x4aff1d108d4ec2c3 }, // 1e-122
+    { 0x843610cb4bf160cb, 0xcedf722a585139ba }, // 1e-121
+    { 0xa54394fe1eedb8fe, 0xc2974eb4ee658828 }, // 1e-120
+    { 0xce947a3da6a9273e, 0x733d226229feea32 }, // 1e-119
+    { 0x811ccc668829b887, 0x0806357d5a3f525f }, // 1e-118
+    { 0xa163ff802a3426a8, 0xca07c2dcb0cf26f7 }, // 1e-117
+    { 0xc9bcff6034c13052, 0xfc89b393dd02f0b5 }, // 1e-116
+    { 0xfc2c3f3841f17c67, 0xbbac2078d443ace2 }, // 1e-115
+    { 0x9d9ba7832936edc0, 0xd54b944b84aa4c0d }, // 1e-114
+    { 0xc5029163f384a931, 0x0a9e795e65d4df11 }, // 1e-113
+    { 0xf64335bcf065d37d, 0x4d4617b5ff4a16d5 }, // 1e-112
+    { 0x99ea0196163fa42e, 0x504bced1bf8e4e45 }, // 1e-111
+    { 0xc06481fb9bcf8d39, 0xe45ec2862f71e1d6 }, // 1e-110
+    { 0xf07da27a82c37088, 0x5d767327bb4e5a4c }, // 1e-109
+    { 0x964e858c91ba2655, 0x3a6a07f8d510f86f }, // 1e-108
+    { 0xbbe226efb628afea, 0x890489f70a55368b }, // 1e-107
+    { 0xeadab0aba3b2dbe5, 0x2b45ac74ccea842e }, // 1e-106
+    { 0x92c8ae6b464fc96f, 0x3b0b8bc90012929d }, // 1e-105
+    { 0xb77ada0617e3bbcb, 0x09ce6ebb40173744 }, // 1e-104
+    { 0xe55990879ddcaabd, 0xcc420a6a101d0515 }, // 1e-103
+    { 0x8f57fa54c2a9eab6, 0x9fa946824a12232d }, // 1e-102
+    { 0xb32df8e9f3546564, 0x47939822dc96abf9 }, // 1e-101
+    { 0xdff9772470297ebd, 0x59787e2b93bc56f7 }, // 1e-100
+    { 0x8bfbea76c619ef36, 0x57eb4edb3c55b65a }, // 1e-99
+    { 0xaefae51477a06b03, 0xede622920b6b23f1 }, // 1e-98
+    { 0xdab99e59958885c4, 0xe95fab368e45eced }, // 1e-97
+    { 0x88b402f7fd75539b, 0x11dbcb0218ebb414 }, // 1e-96
+    { 0xaae103b5fcd2a881, 0xd652bdc29f26a119 }, // 1e-95
+    { 0xd59944a37c0752a2, 0x4be76d3346f0495f }, // 1e-94
+    { 0x857fcae62d8493a5, 0x6f70a4400c562ddb }, // 1e-93
+    { 0xa6dfbd9fb8e5b88e, 0xcb4ccd500f6bb952 }, // 1e-92
+    { 0xd097ad07a71f26b2, 0x7e2000a41346a7a7 }, // 1e-91
+    { 0x825ecc24c873782f, 0x8ed400668c0c28c8 }, // 1e-90
+    { 0xa2f67f2dfa90563b, 0x728900802f0f32fa }, // 1e-89
+    { 0xcbb41ef979346bca, 0x4f2b40a03ad2ffb9 }, // 1e-88
+    { 0xfea126b7d78186bc, 0xe2f610c84987bfa8 }, // 1e-87
+    { 0x9f24b832e6b0f436, 0x0dd9ca7d2df4d7c9 }, // 1e-86
+    { 0xc6ede63fa05d3143, 0x91503d1c79720dbb }, // 1e-85
+    { 0xf8a95fcf88747d94, 0x75a44c6397ce912a }, // 1e-84
+    { 0x9b69dbe1b548ce7c, 0xc986afbe3ee11aba }, // 1e-83
+    { 0xc24452da229b021b, 0xfbe85badce996168 }, // 1e-82
+    { 0xf2d56790ab41c2a2, 0xfae27299423fb9c3 }, // 1e-81
+    { 0x97c560ba6b0919a5, 0xdccd879fc967d41a }, // 1e-80
+    { 0xbdb6b8e905cb600f, 0x5400e987bbc1c920 }, // 1e-79
+    { 0xed246723473e3813, 0x290123e9aab23b68 }, // 1e-78
+    { 0x9436c0760c86e30b, 0xf9a0b6720aaf6521 }, // 1e-77
+    { 0xb94470938fa89bce, 0xf808e40e8d5b3e69 }, // 1e-76
+    { 0xe7958cb87392c2c2, 0xb60b1d1230b20e04 }, // 1e-75
+    { 0x90bd77f3483bb9b9, 0xb1c6f22b5e6f48c2 }, // 1e-74
+    { 0xb4ecd5f01a4aa828, 0x1e38aeb6360b1af3 }, // 1e-73
+    { 0xe2280b6c20dd5232, 0x25c6da63c38de1b0 }, // 1e-72
+    { 0x8d590723948a535f, 0x579c487e5a38ad0e }, // 1e-71
+    { 0xb0af48ec79ace837, 0x2d835a9df0c6d851 }, // 1e-70
+    { 0xdcdb1b2798182244, 0xf8e431456cf88e65 }, // 1e-69
+    { 0x8a08f0f8bf0f156b, 0x1b8e9ecb641b58ff }, // 1e-68
+    { 0xac8b2d36eed2dac5, 0xe272467e3d222f3f }, // 1e-67
+    { 0xd7adf884aa879177, 0x5b0ed81dcc6abb0f }, // 1e-66
+    { 0x86ccbb52ea94baea, 0x98e947129fc2b4e9 }, // 1e-65
+    { 0xa87fea27a539e9a5, 0x3f2398d747b36224 }, // 1e-64
+    { 0xd29fe4b18e88640e, 0x8eec7f0d19a03aad }, // 1e-63
+    { 0x83a3eeeef9153e89, 0x1953cf68300424ac }, // 1e-62
+    { 0xa48ceaaab75a8e2b, 0x5fa8c3423c052dd7 }, // 1e-61
+    { 0xcdb02555653131b6, 0x3792f412cb06794d }, // 1e-60
+    { 0x808e17555f3ebf11, 0xe2bbd88bbee40bd0 }, // 1e-59
+    { 0xa0b19d2ab70e6ed6, 0x5b6aceaeae9d0ec4 }, // 1e-58
+    { 0xc8de047564d20a8b, 0xf245825a5a445275 }, // 1e-57
+    { 0xfb158592be068d2e, 0xeed6e2f0f0d56712 }, // 1e-56
+    { 0x9ced737bb6c4183d, 0x55464dd69685606b }, // 1e-55
+    { 0xc428d05aa4751e4c, 0xaa97e14c3c26b886 }, // 1e-54
+    { 0xf53304714d9265df, 0xd53dd99f4b3066a8 }, // 1e-53
+    { 0x993fe2c6d07b7fab, 0xe546a8038efe4029 }, // 1e-52
+    { 0xbf8fdb78849a5f96, 0xde98520472bdd033 }, // 1e-51
+    { 0xef73d256a5c0f77c, 0x963e66858f6d4440 }, // 1e-50
+    { 0x95a8637627989aad, 0xdde7001379a44aa8 }, // 1e-49
+    { 0xbb127c53b17ec159, 0x5560c018580d5d52 }, // 1e-48
+    { 0xe9d71b689dde71af, 0xaab8f01e6e10b4a6 }, // 1e-47
+    { 0x9226712162ab070d, 0xcab3961304ca70e8 }, // 1e-46
+    { 0xb6b00d69bb55c8d1, 0x3d607b97c5fd0d22 }, // 1e-45
+    { 0xe45c10c42a2b3b05, 0x8cb89a7db77c506a }, // 1e-44
+    { 0x8eb98a7a9a5b04e3, 0x77f3608e92adb242 }, // 1e-43
+    { 0xb267ed1940f1c61c, 0x55f038b237591ed3 }, // 1e-42
+    { 0xdf01e85f912e37a3, 0x6b6c46dec52f6688 }, // 1e-41
+    { 0x8b61313bbabce2c6, 0x2323ac4b3b3da015 }, // 1e-40
+    { 0xae397d8aa96c1b77, 0xabec975e0a0d081a }, // 1e-39
+    { 0xd9c7dced53c72255, 0x96e7bd358c904a21 }, // 1e-38
+    { 0x881cea14545c7575, 0x7e50d64177da2e54 }, // 1e-37
+    { 0xaa242499697392d2, 0xdde50bd1d5d0b9e9 }, // 1e-36
+    { 0xd4ad2dbfc3d07787, 0x955e4ec64b44e864 }, // 1e-35
+    { 0x84ec3c97da624ab4, 0xbd5af13bef0b113e }, // 1e-34
+    { 0xa6274bbdd0fadd61, 0xecb1ad8aeacdd58e }, // 1e-33
+    { 0xcfb11ead453994ba, 0x67de18eda5814af2 }, // 1e-32
+    { 0x81ceb32c4b43fcf4, 0x80eacf948770ced7 }, // 1e-31
+    { 0xa2425ff75e14fc31, 0xa1258379a94d028d }, // 1e-30
+    { 0xcad2f7f5359a3b3e, 0x096ee45813a04330 }, // 1e-29
+    { 0xfd87b5f28300ca0d, 0x8bca9d6e188853fc }, // 1e-28
+    { 0x9e74d1b791e07e48, 0x775ea264cf55347d }, // 1e-27
+    { 0xc612062576589dda, 0x95364afe032a819d }, // 1e-26
+    { 0xf79687aed3eec551, 0x3a83ddbd83f52204 }, // 1e-25
+    { 0x9abe14cd44753b52, 0xc4926a9672793542 }, // 1e-24
+    { 0xc16d9a0095928a27, 0x75b7053c0f178293 }, // 1e-23
+    { 0xf1c90080baf72cb1, 0x5324c68b12dd6338 }, // 1e-22
+    { 0x971da05074da7bee, 0xd3f6fc16ebca5e03 }, // 1e-21
+    { 0xbce5086492111aea, 0x88f4bb1ca6bcf584 }, // 1e-20
+    { 0xec1e4a7db69561a5, 0x2b31e9e3d06c32e5 }, // 1e-19
+    { 0x9392ee8e921d5d07, 0x3aff322e62439fcf }, // 1e-18
+    { 0xb877aa3236a4b449, 0x09befeb9fad487c2 }, // 1e-17
+    { 0xe69594bec44de15b, 0x4c2ebe687989a9b3 }, // 1e-16
+    { 0x901d7cf73ab0acd9, 0x0f9d37014bf60a10 }, // 1e-15
+    { 0xb424dc35095cd80f, 0x538484c19ef38c94 }, // 1e-14
+    { 0xe12e13424bb40e13, 0x2865a5f206b06fb9 }, // 1e-13
+    { 0x8cbccc096f5088cb, 0xf93f87b7442e45d3 }, // 1e-12
+    { 0xafebff0bcb24aafe, 0xf78f69a51539d748 }, // 1e-11
+    { 0xdbe6fecebdedd5be, 0xb573440e5a884d1b }, // 1e-10
+    { 0x89705f4136b4a597, 0x31680a88f8953030 }, // 1e-9
+    { 0xabcc77118461cefc, 0xfdc20d2b36ba7c3d }, // 1e-8
+    { 0xd6bf94d5e57a42bc, 0x3d32907604691b4c }, // 1e-7
+    { 0x8637bd05af6c69b5, 0xa63f9a49c2c1b10f }, // 1e-6
+    { 0xa7c5ac471b478423, 0x0fcf80dc33721d53 }, // 1e-5
+    { 0xd1b71758e219652b, 0xd3c36113404ea4a8 }, // 1e-4
+    { 0x83126e978d4fdf3b, 0x645a1cac083126e9 }, // 1e-3
+    { 0xa3d70a3d70a3d70a, 0x3d70a3d70a3d70a3 }, // 1e-2
+    { 0xcccccccccccccccc, 0xcccccccccccccccc }, // 1e-1
+    { 0x8000000000000000, 0x0000000000000000 }, // 1e0
+    { 0xa000000000000000, 0x0000000000000000 }, // 1e1
+    { 0xc800000000000000, 0x0000000000000000 }, // 1e2
+    { 0xfa00000000000000, 0x0000000000000000 }, // 1e3
+    { 0x9c40000000000000, 0x0000000000000000 }, // 1e4
+    { 0xc350000000000000, 0x0000000000000000 }, // 1e5
+    { 0xf424000000000000, 0x0000000000000000 }, // 1e6
+    { 0x9896800000000000, 0x0000000000000000 }, // 1e7
+    { 0xbebc200000000000, 0x0000000000000000 }, // 1e8
+    { 0xee6b280000000000, 0x0000000000000000 }, // 1e9
+    { 0x9502f90000000000, 0x0000000000000000 }, // 1e10
+    { 0xba43b74000000000, 0x0000000000000000 }, // 1e11
+    { 0xe8d4a51000000000, 0x0000000000000000 }, // 1e12
+    { 0x9184e72a00000000, 0x0000000000000000 }, // 1e13
+    { 0xb5e620f480000000, 0x0000000000000000 }, // 1e14
+    { 0xe35fa931a0000000, 0x0000000000000000 }, // 1e15
+    { 0x8e1bc9bf04000000, 0x0000000000000000 }, // 1e16
+    { 0xb1a2bc2ec5000000, 0x0000000000000000 }, // 1e17
+    { 0xde0b6b3a76400000, 0x0000000000000000 }, // 1e18
+    { 0x8ac7230489e80000, 0x0000000000000000 }, // 1e19
+    { 0xad78ebc5ac620000, 0x0000000000000000 }, // 1e20
+    { 0xd8d726b7177a8000, 0x0000000000000000 }, // 1e21
+    { 0x878678326eac9000, 0x0000000000000000 }, // 1e22
+    { 0xa968163f0a57b400, 0x0000000000000000 }, // 1e23
+    { 0xd3c21bcecceda100, 0x0000000000000000 }, // 1e24
+    { 0x84595161401484a0, 0x0000000000000000 }, // 1e25
+    { 0xa56fa5b99019a5c8, 0x0000000000000000 }, // 1e26
+    { 0xcecb8f27f4200f3a, 0x0000000000000000 }, // 1e27
+    { 0x813f3978f8940984, 0x4000000000000000 }, // 1e28
+    { 0xa18f07d736b90be5, 0x5000000000000000 }, // 1e29
+    { 0xc9f2c9cd04674ede, 0xa400000000000000 }, // 1e30
+    { 0xfc6f7c4045812296, 0x4d00000000000000 }, // 1e31
+    { 0x9dc5ada82b70b59d, 0xf020000000000000 }, // 1e32
+    { 0xc5371912364ce305, 0x6c28000000000000 }, // 1e33
+    { 0xf684df56c3e01bc6, 0xc732000000000000 }, // 1e34
+    { 0x9a130b963a6c115c, 0x3c7f400000000000 }, // 1e35
+    { 0xc097ce7bc90715b3, 0x4b9f100000000000 }, // 1e36
+    { 0xf0bdc21abb48db20, 0x1e86d40000000000 }, // 1e37
+    { 0x96769950b50d88f4, 0x1314448000000000 }, // 1e38
+    { 0xbc143fa4e250eb31, 0x17d955a000000000 }, // 1e39
+    { 0xeb194f8e1ae525fd, 0x5dcfab0800000000 }, // 1e40
+    { 0x92efd1b8d0cf37be, 0x5aa1cae500000000 }, // 1e41
+    { 0xb7abc627050305ad, 0xf14a3d9e40000000 }, // 1e42
+    { 0xe596b7b0c643c719, 0x6d9ccd05d0000000 }, // 1e43
+    { 0x8f7e32ce7bea5c6f, 0xe4820023a2000000 }, // 1e44
+    { 0xb35dbf821ae4f38b, 0xdda2802c8a800000 }, // 1e45
+    { 0xe0352f62a19e306e, 0xd50b2037ad200000 }, // 1e46
+    { 0x8c213d9da502de45, 0x4526f422cc340000 }, // 1e47
+    { 0xaf298d050e4395d6, 0x9670b12b7f410000 }, // 1e48
+    { 0xdaf3f04651d47b4c, 0x3c0cdd765f114000 }, // 1e49
+    { 0x88d8762bf324cd0f, 0xa5880a69fb6ac800 }, // 1e50
+    { 0xab0e93b6efee0053, 0x8eea0d047a457a00 }, // 1e51
+    { 0xd5d238a4abe98068, 0x72a4904598d6d880 }, // 1e52
+    { 0x85a36366eb71f041, 0x47a6da2b7f864750 }, // 1e53
+    { 0xa70c3c40a64e6c51, 0x999090b65f67d924 }, // 1e54
+    { 0xd0cf4b50cfe20765, 0xfff4b4e3f741cf6d }, // 1e55
+    { 0x82818f1281ed449f, 0xbff8f10e7a8921a4 }, // 1e56
+    { 0xa321f2d7226895c7, 0xaff72d52192b6a0d }, // 1e57
+    { 0xcbea6f8ceb02bb39, 0x9bf4f8a69f764490 }, // 1e58
+    { 0xfee50b7025c36a08, 0x02f236d04753d5b4 }, // 1e59
+    { 0x9f4f2726179a2245, 0x01d762422c946590 }, // 1e60
+    { 0xc722f0ef9d80aad6, 0x424d3ad2b7b97ef5 }, // 1e61
+    { 0xf8ebad2b84e0d58b, 0xd2e0898765a7deb2 }, // 1e62
+    { 0x9b934c3b330c8577, 0x63cc55f49f88eb2f }, // 1e63
+    { 0xc2781f49ffcfa6d5, 0x3cbf6b71c76b25fb }, // 1e64
+    { 0xf316271c7fc3908a, 0x8bef464e3945ef7a }, // 1e65
+    { 0x97edd871cfda3a56, 0x97758bf0e3cbb5ac }, // 1e66
+    { 0xbde94e8e43d0c8ec, 0x3d52eeed1cbea317 }, // 1e67
+    { 0xed63a231d4c4fb27, 0x4ca7aaa863ee4bdd }, // 1e68
+    { 0x945e455f24fb1cf8, 0x8fe8caa93e74ef6a }, // 1e69
+    { 0xb975d6b6ee39e436, 0xb3e2fd538e122b44 }, // 1e70
+    { 0xe7d34c64a9c85d44, 0x60dbbca87196b616 }, // 1e71
+    { 0x90e40fbeea1d3a4a, 0xbc8955e946fe31cd }, // 1e72
+    { 0xb51d13aea4a488dd, 0x6babab6398bdbe41 }, // 1e73
+    { 0xe264589a4dcdab14, 0xc696963c7eed2dd1 }, // 1e74
+    { 0x8d7eb76070a08aec, 0xfc1e1de5cf543ca2 }, // 1e75
+    { 0xb0de65388cc8ada8, 0x3b25a55f43294bcb }, // 1e76
+    { 0xdd15fe86affad912, 0x49ef0eb713f39ebe }, // 1e77
+    { 0x8a2dbf142dfcc7ab, 0x6e3569326c784337 }, // 1e78
+    { 0xacb92ed9397bf996, 0x49c2c37f07965404 }, // 1e79
+    { 0xd7e77a8f87daf7fb, 0xdc33745ec97be906 }, // 1e80
+    { 0x86f0ac99b4e8dafd, 0x69a028bb3ded71a3 }, // 1e81
+    { 0xa8acd7c0222311bc, 0xc40832ea0d68ce0c }, // 1e82
+    { 0xd2d80db02aabd62b, 0xf50a3fa490c30190 }, // 1e83
+    { 0x83c7088e1aab65db, 0x792667c6da79e0fa }, // 1e84
+    { 0xa4b8cab1a1563f52, 0x577001b891185938 }, // 1e85
+    { 0xcde6fd5e09abcf26, 0xed4c0226b55e6f86 }, // 1e86
+    { 0x80b05e5ac60b6178, 0x544f8158315b05b4 }, // 1e87
+    { 0xa0dc75f1778e39d6, 0x696361ae3db1c721 }, // 1e88
+    { 0xc913936dd571c84c, 0x03bc3a19cd1e38e9 }, // 1e89
+    { 0xfb5878494ace3a5f, 0x04ab48a04065c723 }, // 1e90
+    { 0x9d174b2dcec0e47b, 0x62eb0d64283f9c76 }, // 1e91
+    { 0xc45d1df942711d9a, 0x3ba5d0bd324f8394 }, // 1e92
+    { 0xf5746577930d6500, 0xca8f44ec7ee36479 }, // 1e93
+    { 0x9968bf6abbe85f20, 0x7e998b13cf4e1ecb }, // 1e94
+    { 0xbfc2ef456ae276e8, 0x9e3fedd8c321a67e }, // 1e95
+    { 0xefb3ab16c59b14a2, 0xc5cfe94ef3ea101e }, // 1e96
+    { 0x95d04aee3b80ece5, 0xbba1f1d158724a12 }, // 1e97
+    { 0xbb445da9ca61281f, 0x2a8a6e45ae8edc97 }, // 1e98
+    { 0xea1575143cf97226, 0xf52d09d71a3293bd }, // 1e99
+    { 0x924d692ca61be758, 0x593c2626705f9c56 }, // 1e100
+    { 0xb6e0c377cfa2e12e, 0x6f8b2fb00c77836c }, // 1e101
+    { 0xe498f455c38b997a, 0x0b6dfb9c0f956447 }, // 1e102
+    { 0x8edf98b59a373fec, 0x4724bd4189bd5eac }, // 1e103
+    { 0xb2977ee300c50fe7, 0x58edec91ec2cb657 }, // 1e104
+    { 0xdf3d5e9bc0f653e1, 0x2f2967b66737e3ed }, // 1e105
+    { 0x8b865b215899f46c, 0xbd79e0d20082ee74 }, // 1e106
+    { 0xae67f1e9aec07187, 0xecd8590680a3aa11 }, // 1e107
+    { 0xda01ee641a708de9, 0xe80e6f4820cc9495 }, // 1e108
+    { 0x884134fe908658b2, 0x3109058d147fdcdd }, // 1e109
+    { 0xaa51823e34a7eede, 0xbd4b46f0599fd415 }, // 1e110
+    { 0xd4e5e2cdc1d1ea96, 0x6c9e18ac7007c91a }, // 1e111
+    { 0x850fadc09923329e, 0x03e2cf6bc604ddb0 }, // 1e112
+    { 0xa6539930bf6bff45, 0x84db8346b786151c }, // 1e113
+    { 0xcfe87f7cef46ff16, 0xe612641865679a63 }, // 1e114
+    { 0x81f14fae158c5f6e, 0x4fcb7e8f3f60c07e }, // 1e115
+    { 0xa26da3999aef7749, 0xe3be5e330f38f09d }, // 1e116
+    { 0xcb090c8001ab551c, 0x5cadf5bfd3072cc5 }, // 1e117
+    { 0xfdcb4fa002162a63, 0x73d9732fc7c8f7f6 }, // 1e118
+    { 0x9e9f11c4014dda7e, 0x2867e7fddcdd9afa }, // 1e119
+    { 0xc646d63501a1511d, 0xb281e1fd541501b8 }, // 1e120
+    { 0xf7d88bc24209a565, 0x1f225a7ca91a4226 }, // 1e121
+    { 0x9ae757596946075f, 0x3375788de9b06958 }, // 1e122
+    { 0xc1a12d2fc3978937, 0x0052d6b1641c83ae }, // 1e123
+    { 0xf209787bb47d6b84, 0xc0678c5dbd23a49a }, // 1e124
+    { 0x9745eb4d50ce6332, 0xf840b7ba963646e0 }, // 1e125
+    { 0xbd176620a501fbff, 0xb650e5a93bc3d898 }, // 1e126
+    { 0xec5d3fa8ce427aff, 0xa3e51f138ab4cebe }, // 1e127
+    { 0x93ba47c980e98cdf, 0xc66f336c36b10137 }, // 1e128
+    { 0xb8a8d9bbe123f017, 0xb80b0047445d4184 }, // 1e129
+    { 0xe6d3102ad96cec1d, 0xa60dc059157491e5 }, // 1e130
+    { 0x9043ea1ac7e41392, 0x87c89837ad68db2f }, // 1e131
+    { 0xb454e4a179dd1877, 0x29babe4598c311fb }, // 1e132
+    { 0xe16a1dc9d8545e94, 0xf4296dd6fef3d67a }, // 1e133
+    { 0x8ce2529e2734bb1d, 0x1899e4a65f58660c }, // 1e134
+    { 0xb01ae745b101e9e4, 0x5ec05dcff72e7f8f }, // 1e135
+    { 0xdc21a1171d42645d, 0x76707543f4fa1f73 }, // 1e136
+    { 0x899504ae72497eba, 0x6a06494a791c53a8 }, // 1e137
+    { 0xabfa45da0edbde69, 0x0487db9d17636892 }, // 1e138
+    { 0xd6f8d7509292d603, 0x45a9d2845d3c42b6 }, // 1e139
+    { 0x865b86925b9bc5c2, 0x0b8a2392ba45a9b2 }, // 1e140
+    { 0xa7f26836f282b732, 0x8e6cac7768d7141e }, // 1e141
+    { 0xd1ef0244af2364ff, 0x3207d795430cd926 }, // 1e142
+    { 0x8335616aed761f1f, 0x7f44e6bd49e807b8 }, // 1e143
+    { 0xa402b9c5a8d3a6e7, 0x5f16206c9c6209a6 }, // 1e144
+    { 0xcd036837130890a1, 0x36dba887c37a8c0f }, // 1e145
+    { 0x802221226be55a64, 0xc2494954da2c9789 }, // 1e146
+    { 0xa02aa96b06deb0fd, 0xf2db9baa10b7bd6c }, // 1e147
+    { 0xc83553c5c8965d3d, 0x6f92829494e5acc7 }, // 1e148
+    { 0xfa42a8b73abbf48c, 0xcb772339ba1f17f9 }, // 1e149
+    { 0x9c69a97284b578d7, 0xff2a760414536efb }, // 1e150
+    { 0xc38413cf25e2d70d, 0xfef5138519684aba }, // 1e151
+    { 0xf46518c2ef5b8cd1, 0x7eb258665fc25d69 }, // 1e152
+    { 0x98bf2f79d5993802, 0xef2f773ffbd97a61 }, // 1e153
+    { 0xbeeefb584aff8603, 0xaafb550ffacfd8fa }, // 1e154
+    { 0xeeaaba2e5dbf6784, 0x95ba2a53f983cf38 }, // 1e155
+    { 0x952ab45cfa97a0b2, 0xdd945a747bf26183 }, // 1e156
+    { 0xba756174393d88df, 0x94f971119aeef9e4 }, // 1e157
+    { 0xe912b9d1478ceb17, 0x7a37cd5601aab85d }, // 1e158
+    { 0x91abb422ccb812ee, 0xac62e055c10ab33a }, // 1e159
+    { 0xb616a12b7fe617aa, 0x577b986b314d6009 }, // 1e160
+    { 0xe39c49765fdf9d94, 0xed5a7e85fda0b80b }, // 1e161
+    { 0x8e41ade9fbebc27d, 0x14588f13be847307 }, // 1e162
+    { 0xb1d219647ae6b31c, 0x596eb2d8ae258fc8 }, // 1e163
+    { 0xde469fbd99a05fe3, 0x6fca5f8ed9aef3bb }, // 1e164
+    { 0x8aec23d680043bee, 0x25de7bb9480d5854 }, // 1e165
+    { 0xada72ccc20054ae9, 0xaf561aa79a10ae6a }, // 1e166
+    { 0xd910f7ff28069da4, 0x1b2ba1518094da04 }, // 1e167
+    { 0x87aa9aff79042286, 0x90fb44d2f05d0842 }, // 1e168
+    { 0xa99541bf57452b28, 0x353a1607ac744a53 }, // 1e169
+    { 0xd3fa922f2d1675f2, 0x42889b8997915ce8 }, // 1e170
+    { 0x847c9b5d7c2e09b7, 0x69956135febada11 }, // 1e171
+    { 0xa59bc234db398c25, 0x43fab9837e699095 }, // 1e172
+    { 0xcf02b2c21207ef2e, 0x94f967e45e03f4bb }, // 1e173
+    { 0x8161afb94b44f57d, 0x1d1be0eebac278f5 }, // 1e174
+    { 0xa1ba1ba79e1632dc, 0x6462d92a69731732 }, // 1e175
+    { 0xca28a291859bbf93, 0x7d7b8f7503cfdcfe }, // 1e176
+    { 0xfcb2cb35e702af78, 0x5cda735244c3d43e }, // 1e177
+    { 0x9defbf01b061adab, 0x3a0888136afa64a7 }, // 1e178
+    { 0xc56baec21c7a1916, 0x088aaa1845b8fdd0 }, // 1e179
+    { 0xf6c69a72a3989f5b, 0x8aad549e57273d45 }, // 1e180
+    { 0x9a3c2087a63f6399, 0x36ac54e2f678864b }, // 1e181
+    { 0xc0cb28a98fcf3c7f, 0x84576a1bb416a7dd }, // 1e182
+    { 0xf0fdf2d3f3c30b9f, 0x656d44a2a11c51d5 }, // 1e183
+    { 0x969eb7c47859e743, 0x9f644ae5a4b1b325 }, // 1e184
+    { 0xbc4665b596706114, 0x873d5d9f0dde1fee }, // 1e185
+    { 0xeb57ff22fc0c7959, 0xa90cb506d155a7ea }, // 1e186
+    { 0x9316ff75dd87cbd8, 0x09a7f12442d588f2 }, // 1e187
+    { 0xb7dcbf5354e9bece, 0x0c11ed6d538aeb2f }, // 1e188
+    { 0xe5d3ef282a242e81, 0x8f1668c8a86da5fa }, // 1e189
+    { 0x8fa475791a569d10, 0xf96e017d694487bc }, // 1e190
+    { 0xb38d92d760ec4455, 0x37c981dcc395a9ac }, // 1e191
+    { 0xe070f78d3927556a, 0x85bbe253f47b1417 }, // 1e192
+    { 0x8c469ab843b89562, 0x93956d7478ccec8e }, // 1e193
+    { 0xaf58416654a6babb, 0x387ac8d1970027b2 }, // 1e194
+    { 0xdb2e51bfe9d0696a, 0x06997b05fcc0319e }, // 1e195
+    { 0x88fcf317f22241e2, 0x441fece3bdf81f03 }, // 1e196
+    { 0xab3c2fddeeaad25a, 0xd527e81cad7626c3 }, // 1e197
+    { 0xd60b3bd56a5586f1, 0x8a71e223d8d3b074 }, // 1e198
+    { 0x85c7056562757456, 0xf6872d5667844e49 }, // 1e199
+    { 0xa738c6bebb12d16c, 0xb428f8ac016561db }, // 1e200
+    { 0xd106f86e69d785c7, 0xe13336d701beba52 }, // 1e201
+    { 0x82a45b450226b39c, 0xecc0024661173473 }, // 1e202
+    { 0xa34d721642b06084, 0x27f002d7f95d0190 }, // 1e203
+    { 0xcc20ce9bd35c78a5, 0x31ec038df7b441f4 }, // 1e204
+    { 0xff290242c83396ce, 0x7e67047175a15271 }, // 1e205
+    { 0x9f79a169bd203e41, 0x0f0062c6e984d386 }, // 1e206
+    { 0xc75809c42c684dd1, 0x52c07b78a3e60868 }, // 1e207
+    { 0xf92e0c3537826145, 0xa7709a56ccdf8a82 }, // 1e208
+    { 0x9bbcc7a142b17ccb, 0x88a66076400bb691 }, // 1e209
+    { 0xc2abf989935ddbfe, 0x6acff893d00ea435 }, // 1e210
+    { 0xf356f7ebf83552fe, 0x0583f6b8c4124d43 }, // 1e211
+    { 0x98165af37b2153de, 0xc3727a337a8b704a }, // 1e212
+    { 0xbe1bf1b059e9a8d6, 0x744f18c0592e4c5c }, // 1e213
+    { 0xeda2ee1c7064130c, 0x1162def06f79df73 }, // 1e214
+    { 0x9485d4d1c63e8be7, 0x8addcb5645ac2ba8 }, // 1e215
+    { 0xb9a74a0637ce2ee1, 0x6d953e2bd7173692 }, // 1e216
+    { 0xe8111c87c5c1ba99, 0xc8fa8db6ccdd0437 }, // 1e217
+    { 0x910ab1d4db9914a0, 0x1d9c9892400a22a2 }, // 1e218
+    { 0xb54d5e4a127f59c8, 0x2503beb6d00cab4b }, // 1e219
+    { 0xe2a0b5dc971f303a, 0x2e44ae64840fd61d }, // 1e220
+    { 0x8da471a9de737e24, 0x5ceaecfed289e5d2 }, // 1e221
+    { 0xb10d8e1456105dad, 0x7425a83e872c5f47 }, // 1e222
+    { 0xdd50f1996b947518, 0xd12f124e28f77719 }, // 1e223
+    { 0x8a5296ffe33cc92f, 0x82bd6b70d99aaa6f }, // 1e224
+    { 0xace73cbfdc0bfb7b, 0x636cc64d1001550b }, // 1e225
+    { 0xd8210befd30efa5a, 0x3c47f7e05401aa4e }, // 1e226
+    { 0x8714a775e3e95c78, 0x65acfaec34810a71 }, // 1e227
+    { 0xa8d9d1535ce3b396, 0x7f1839a741a14d0d }, // 1e228
+    { 0xd31045a8341ca07c, 0x1ede48111209a050 }, // 1e229
+    { 0x83ea2b892091e44d, 0x934aed0aab460432 }, // 1e230
+    { 0xa4e4b66b68b65d60, 0xf81da84d5617853f }, // 1e231
+    { 0xce1de40642e3f4b9, 0x36251260ab9d668e }, // 1e232
+    { 0x80d2ae83e9ce78f3, 0xc1d72b7c6b426019 }, // 1e233
+    { 0xa1075a24e4421730, 0xb24cf65b8612f81f }, // 1e234
+    { 0xc94930ae1d529cfc, 0xdee033f26797b627 }, // 1e235
+    { 0xfb9b7cd9a4a7443c, 0x169840ef017da3b1 }, // 1e236
+    { 0x9d412e0806e88aa5, 0x8e1f289560ee864e }, // 1e237
+    { 0xc491798a08a2ad4e, 0xf1a6f2bab92a27e2 }, // 1e238
+    { 0xf5b5d7ec8acb58a2, 0xae10af696774b1db }, // 1e239
+    { 0x9991a6f3d6bf1765, 0xacca6da1e0a8ef29 }, // 1e240
+    { 0xbff610b0cc6edd3f, 0x17fd090a58d32af3 }, // 1e241
+    { 0xeff394dcff8a948e, 0xddfc4b4cef07f5b0 }, // 1e242
+    { 0x95f83d0a1fb69cd9, 0x4abdaf101564f98e }, // 1e243
+    { 0xbb764c4ca7a4440f, 0x9d6d1ad41abe37f1 }, // 1e244
+    { 0xea53df5fd18d5513, 0x84c86189216dc5ed }, // 1e245
+    { 0x92746b9be2f8552c, 0x32fd3cf5b4e49bb4 }, // 1e246
+    { 0xb7118682dbb66a77, 0x3fbc8c33221dc2a1 }, // 1e247
+    { 0xe4d5e82392a40515, 0x0fabaf3feaa5334a }, // 1e248
+    { 0x8f05b1163ba6832d, 0x29cb4d87f2a7400e }, // 1e249
+    { 0xb2c71d5bca9023f8, 0x743e20e9ef511012 }, // 1e250
+    { 0xdf78e4b2bd342cf6, 0x914da9246b255416 }, // 1e251
+    { 0x8bab8eefb6409c1a, 0x1ad089b6c2f7548e }, // 1e252
+    { 0xae9672aba3d0c320, 0xa184ac2473b529b1 }, // 1e253
+    { 0xda3c0f568cc4f3e8, 0xc9e5d72d90a2741e }, // 1e254
+    { 0x8865899617fb1871, 0x7e2fa67c7a658892 }, // 1e255
+    { 0xaa7eebfb9df9de8d, 0xddbb901b98feeab7 }, // 1e256
+    { 0xd51ea6fa85785631, 0x552a74227f3ea565 }, // 1e257
+    { 0x8533285c936b35de, 0xd53a88958f87275f }, // 1e258
+    { 0xa67ff273b8460356, 0x8a892abaf368f137 }, // 1e259
+    { 0xd01fef10a657842c, 0x2d2b7569b0432d85 }, // 1e260
+    { 0x8213f56a67f6b29b, 0x9c3b29620e29fc73 }, // 1e261
+    { 0xa298f2c501f45f42, 0x8349f3ba91b47b8f }, // 1e262
+    { 0xcb3f2f7642717713, 0x241c70a936219a73 }, // 1e263
+    { 0xfe0efb53d30dd4d7, 0xed238cd383aa0110 }, // 1e264
+    { 0x9ec95d1463e8a506, 0xf4363804324a40aa }, // 1e265
+    { 0xc67bb4597ce2ce48, 0xb143c6053edcd0d5 }, // 1e266
+    { 0xf81aa16fdc1b81da, 0xdd94b7868e94050a }, // 1e267
+    { 0x9b10a4e5e9913128, 0xca7cf2b4191c8326 }, // 1e268
+    { 0xc1d4ce1f63f57d72, 0xfd1c2f611f63a3f0 }, // 1e269
+    { 0xf24a01a73cf2dccf, 0xbc633b39673c8cec }, // 1e270
+    { 0x976e41088617ca01, 0xd5be0503e085d813 }, // 1e271
+    { 0xbd49d14aa79dbc82, 0x4b2d8644d8a74e18 }, // 1e272
+    { 0xec9c459d51852ba2, 0xddf8e7d60ed1219e }, // 1e273
+    { 0x93e1ab8252f33b45, 0xcabb90e5c942b503 }, // 1e274
+    { 0xb8da1662e7b00a17, 0x3d6a751f3b936243 }, // 1e275
+    { 0xe7109bfba19c0c9d, 0x0cc512670a783ad4 }, // 1e276
+    { 0x906a617d450187e2, 0x27fb2b80668b24c5 }, // 1e277
+    { 0xb484f9dc9641e9da, 0xb1f9f660802dedf6 }, // 1e278
+    { 0xe1a63853bbd26451, 0x5e7873f8a0396973 }, // 1e279
+    { 0x8d07e33455637eb2, 0xdb0b487b6423e1e8 }, // 1e280
+    { 0xb049dc016abc5e5f, 0x91ce1a9a3d2cda62 }, // 1e281
+    { 0xdc5c5301c56b75f7, 0x7641a140cc7810fb }, // 1e282
+    { 0x89b9b3e11b6329ba, 0xa9e904c87fcb0a9d }, // 1e283
+    { 0xac2820d9623bf429, 0x546345fa9fbdcd44 }, // 1e284
+    { 0xd732290fbacaf133, 0xa97c177947ad4095 }, // 1e285
+    { 0x867f59a9d4bed6c0, 0x49ed8eabcccc485d }, // 1e286
+    { 0xa81f301449ee8c70, 0x5c68f256bfff5a74 }, // 1e287
+    { 0xd226fc195c6a2f8c, 0x73832eec6fff3111 }, // 1e288
+    { 0x83585d8fd9c25db7, 0xc831fd53c5ff7eab }, // 1e289
+    { 0xa42e74f3d032f525, 0xba3e7ca8b77f5e55 }, // 1e290
+    { 0xcd3a1230c43fb26f, 0x28ce1bd2e55f35eb }, // 1e291
+    { 0x80444b5e7aa7cf85, 0x7980d163cf5b81b3 }, // 1e292
+    { 0xa0555e361951c366, 0xd7e105bcc332621f }, // 1e293
+    { 0xc86ab5c39fa63440, 0x8dd9472bf3fefaa7 }, // 1e294
+    { 0xfa856334878fc150, 0xb14f98f6f0feb951 }, // 1e295
+    { 0x9c935e00d4b9d8d2, 0x6ed1bf9a569f33d3 }, // 1e296
+    { 0xc3b8358109e84f07, 0x0a862f80ec4700c8 }, // 1e297
+    { 0xf4a642e14c6262c8, 0xcd27bb612758c0fa }, // 1e298
+    { 0x98e7e9cccfbd7dbd, 0x8038d51cb897789c }, // 1e299
+    { 0xbf21e44003acdd2c, 0xe0470a63e6bd56c3 }, // 1e300
+    { 0xeeea5d5004981478, 0x1858ccfce06cac74 }, // 1e301
+    { 0x95527a5202df0ccb, 0x0f37801e0c43ebc8 }, // 1e302
+    { 0xbaa718e68396cffd, 0xd30560258f54e6ba }, // 1e303
+    { 0xe950df20247c83fd, 0x47c6b82ef32a2069 }, // 1e304
+    { 0x91d28b7416cdd27e, 0x4cdc331d57fa5441 }, // 1e305
+    { 0xb6472e511c81471d, 0xe0133fe4adf8e952 }, // 1e306
+    { 0xe3d8f9e563a198e5, 0x58180fddd97723a6 }, // 1e307
+    { 0x8e679c2f5e44ff8f, 0x570f09eaa7ea7648 }, // 1e308
+    { 0xb201833b35d63f73, 0x2cd2cc6551e513da }, // 1e309
+    { 0xde81e40a034bcf4f, 0xf8077f7ea65e58d1 }, // 1e310
+    { 0x8b112e86420f6191, 0xfb04afaf27faf782 }, // 1e311
+    { 0xadd57a27d29339f6, 0x79c5db9af1f9b563 }, // 1e312
+    { 0xd94ad8b1c7380874, 0x18375281ae7822bc }, // 1e313
+    { 0x87cec76f1c830548, 0x8f2293910d0b15b5 }, // 1e314
+    { 0xa9c2794ae3a3c69a, 0xb2eb3875504ddb22 }, // 1e315
+    { 0xd433179d9c8cb841, 0x5fa60692a46151eb }, // 1e316
+    { 0x849feec281d7f328, 0xdbc7c41ba6bcd333 }, // 1e317
+    { 0xa5c7ea73224deff3, 0x12b9b522906c0800 }, // 1e318
+    { 0xcf39e50feae16bef, 0xd768226b34870a00 }, // 1e319
+    { 0x81842f29f2cce375, 0xe6a1158300d46640 }, // 1e320
+    { 0xa1e53af46f801c53, 0x60495ae3c1097fd0 }, // 1e321
+    { 0xca5e89b18b602368, 0x385bb19cb14bdfc4 }, // 1e322
+    { 0xfcf62c1dee382c42, 0x46729e03dd9ed7b5 }, // 1e323
+    { 0x9e19db92b4e31ba9, 0x6c07a2c26a8346d1 }, // 1e324
+    { 0xc5a05277621be293, 0xc7098b7305241885 }, // 1e325
+    { 0xf70867153aa2db38, 0xb8cbee4fc66d1ea7 }, // 1e326
+    { 0x9a65406d44a5c903, 0x737f74f1dc043328 }, // 1e327
+    { 0xc0fe908895cf3b44, 0x505f522e53053ff2 }, // 1e328
+    { 0xf13e34aabb430a15, 0x647726b9e7c68fef }, // 1e329
+    { 0x96c6e0eab509e64d, 0x5eca783430dc19f5 }, // 1e330
+    { 0xbc789925624c5fe0, 0xb67d16413d132072 }, // 1e331
+    { 0xeb96bf6ebadf77d8, 0xe41c5bd18c57e88f }, // 1e332
+    { 0x933e37a534cbaae7, 0x8e91b962f7b6f159 }, // 1e333
+    { 0xb80dc58e81fe95a1, 0x723627bbb5a4adb0 }, // 1e334
+    { 0xe61136f2227e3b09, 0xcec3b1aaa30dd91c }, // 1e335
+    { 0x8fcac257558ee4e6, 0x213a4f0aa5e8a7b1 }, // 1e336
+    { 0xb3bd72ed2af29e1f, 0xa988e2cd4f62d19d }, // 1e337
+    { 0xe0accfa875af45a7, 0x93eb1b80a33b8605 }, // 1e338
+    { 0x8c6c01c9498d8b88, 0xbc72f130660533c3 }, // 1e339
+    { 0xaf87023b9bf0ee6a, 0xeb8fad7c7f8680b4 }, // 1e340
+    { 0xdb68c2ca82ed2a05, 0xa67398db9f6820e1 }, // 1e341
+    { 0x892179be91d43a43, 0x88083f8943a1148c }, // 1e342
+    { 0xab69d82e364948d4, 0x6a0a4f6b948959b0 }, // 1e343
+    { 0xd6444e39c3db9b09, 0x848ce34679abb01c }, // 1e344
+    { 0x85eab0e41a6940e5, 0xf2d80e0c0c0b4e11 }, // 1e345
+    { 0xa7655d1d2103911f, 0x6f8e118f0f0e2195 }, // 1e346
+    { 0xd13eb46469447567, 0x4b7195f2d2d1a9fb }, // 1e347
+};
+
+static inline int floor_log2_pow10(int q) {
+    return (q * 217706) >> 16;
+}
+
+/* multiply(a, b, lo)
+ *
+ * Return the high 64 bits of the 128-bit product a * b and store the low 64 bits in lo.
+ */
+static inline uint64_t multiply(uint64_t a, uint64_t b, uint64_t &lo) {
+#if defined(__SIZEOF_INT128__)
+    const unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    lo = static_cast<uint64_t>(product);
+    return static_cast<uint64_t>(product >> 64);
+#else
+    const uint64_t a_lo = a & 0xffffffff, a_hi = a >> 32;
+    const uint64_t b_lo = b & 0xffffffff, b_hi = b >> 32;
+    const uint64_t p0 = a_lo * b_lo, p1 = a_lo * b_hi, p2 = a_hi * b_lo, p3 = a_hi * b_hi;
+    const uint64_t mid = (p0 >> 32) + (p1 & 0xffffffff) + (p2 & 0xffffffff);
+    lo = (mid << 32) | (p0 & 0xffffffff);
+    return p3 + (p1 >> 32) + (p2 >> 32) + (mid >> 32);
+#endif
+}
+
+static inline int leading_zeros(uint64_t x) {
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanReverse64(&index, x);
+    return 63 - static_cast<int>(index);
+#elif defined(_MSC_VER)
+    int n = 0;
+    while (!(x & (uint64_t(1) << 63))) {
+        x <<= 1;
+        n++;
+    }
+    return n;
+#else
+    return __builtin_clzll(x);
+#endif
+}
+
+static inline double bits_to_double(uint64_t bits) {
+    double value;
+    std::memcpy(&value, &bits, sizeof value);
+    return value;
+}
+
+static inline uint64_t double_to_bits(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof bits);
+    return bits;
+}
+
+/* eisel_lemire(mantissa, exponent, negative, out)
+ *
+ * Compute the double nearest to mantissa * 10^exponent. Return false if the result cannot
+ * be decided from 128 bits of the power of ten, or lies outside the normal range.
+ */
+static bool eisel_lemire(uint64_t mantissa, long exponent, bool negative, double &out) {
+    if (mantissa == 0) {
+        out = negative ? -0.0 : 0.0;
+        return true;
+    }
+    if (exponent < pow10_min_exponent || exponent > pow10_max_exponent)
+        return false;
+
+    const int q = static_cast<int>(exponent);
+    const uint64_t *pow10 = pow10_significands[q - pow10_min_exponent];
+
+    // Normalize, then multiply by the truncated power of ten.
+    const int clz = leading_zeros(mantissa);
+    mantissa <<= clz;
+    uint64_t exp2 = static_cast<uint64_t>(floor_log2_pow10(q) + 64 + 1023) - clz;
+
+    uint64_t x_lo;
+    uint64_t x_hi = multiply(mantissa, pow10[0], x_lo);
+
+    // If the truncation might matter, widen the product with the next 64 bits of the power.
+    if ((x_hi & 0x1ff) == 0x1ff && x_lo + mantissa < mantissa) {
+        uint64_t y_lo;
+        const uint64_t y_hi = multiply(mantissa, pow10[1], y_lo);
+        uint64_t merged_hi = x_hi, merged_lo = x_lo + y_hi;
+        if (merged_lo < x_lo)
+            merged_hi++;
+        if ((merged_hi & 0x1ff) == 0x1ff && merged_lo + 1 == 0 && y_lo + mantissa < mantissa)
+            return false;
+        x_hi = merged_hi;
+        x_lo = merged_lo;
+    }
+
+    // Shift to 54 bits.
+    const uint64_t msb = x_hi >> 63;
+    uint64_t result = x_hi >> (msb + 9);
+    exp2 -= 1 ^ msb;
+
+    // A halfway case cannot be rounded correctly from here.
+    if (x_lo == 0 && (x_hi & 0x1ff) == 0 && (result & 3) == 1)
+        return false;
+
+    // Round to 53 bits.
+    result += result & 1;
+    result >>= 1;
+    if (result >> 53) {
+        result >>= 1;
+        exp2++;
+    }
+
+    // Subnormals, infinities and NaNs are left to the fallback.
+    if (exp2 - 1 >= 0x7ff - 1)
+        return false;
+
+    uint64_t bits = (exp2 << 52) | (result & ((uint64_t(1) << 52) - 1));
+    if (negative)
+        bits |= uint64_t(1) << 63;
+    out = bits_to_double(bits);
+    return true;
+}
+
+/* strtod_c(text, length)
+ *
+ * Convert a validated JSON number with strtod, substituting the current locale's decimal
+ * point for '.', which is all the locale can change about the syntax strtod accepts.
+ */
+static double strtod_c(const char *text, size_t length) {
+    string buf(text, length);
+    const char *point = localeconv()->decimal_point;
+    if (point[0] != '.' || point[1] != '\0') {
+        const size_t dot = buf.find('.');
+        if (dot != string::npos)
+            buf.replace(dot, 1, point);
+    }
+    return std::strtod(buf.c_str(), nullptr);
+}
+
+/* decimal_to_double(negative, mantissa, exponent, truncated, text, length)
+ *
+ * Return the double nearest to the number spelled by text, which has the decimal value
+ * mantissa * 10^exponent. If truncated is set, nonzero digits were dropped from mantissa.
+ */
+static double decimal_to_double(bool negative, uint64_t mantissa, long exponent,
+                                bool truncated, const char *text, size_t length) {
+    static const double exact_pow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+    };
+
+    double value;
+    if (!truncated) {
+        // Both mantissa and 10^|exponent| are exact doubles, so one IEEE operation rounds
+        // correctly.
+        if (mantissa <= (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22) {
+            value = static_cast<double>(mantissa);
+            value = exponent < 0 ? value / exact_pow10[-exponent] : value * exact_pow10[exponent];
+            return negative ? -value : value;
+        }
+        if (eisel_lemire(mantissa, exponent, negative, value))
+            return value;
+    } else {
+        // The true value lies between mantissa and mantissa + 1 (scaled); if both round the
+        // same way, so does it.
+        double upper;
+        if (eisel_lemire(mantissa, exponent, negative, value)
+                && eisel_lemire(mantissa + 1, exponent, negative, upper) && value == upper)
+            return value;
+    }
+    return strtod_c(text, length);
+}
+
+/* DiyFp
+ *
+ * An unnormalized floating-point number f * 2^e with a 64-bit significand, as used by Grisu.
+ */
+struct DiyFp {
+    uint64_t f;
+    int e;
+
+    DiyFp(uint64_t f, int e) : f(f), e(e) {}
+
+    DiyFp operator-(const DiyFp &other) const {
+        return DiyFp(f - other.f, e);
+    }
+
+    // Product rounded to 64 bits.
+    DiyFp operator*(const DiyFp &other) const {
+        uint64_t lo;
+        const uint64_t hi = multiply(f, other.f, lo);
+        return DiyFp(hi + (lo >> 63), e + other.e + 64);
+    }
+
+    DiyFp normalized() const {
+        const int shift = leading_zeros(f);
+        return DiyFp(f << shift, e - shift);
+    }
+};
+
+/* grisu2_round(buf, len, dist, delta, rest, ten_k)
+ *
+ * Nudge the last digit of buf towards w, as long as it stays within the rounding interval.
+ */
+static void grisu2_round(char *buf, int len, uint64_t dist, uint64_t delta, uint64_t rest,
+                         uint64_t ten_k) {
+    while (rest < dist && delta - rest >= ten_k
+           && (rest + ten_k < dist || dist - rest > rest + ten_k - dist)) {
+        buf[len - 1]--;
+        rest += ten_k;
+    }
+}
+
+/* grisu2(value, buf, len, decimal_exponent)
+ *
+ * Write the digits of a positive, finite value to buf, such that value is the double
+ * nearest to buf * 10^decimal_exponent.
+ */
+static void grisu2(double value, char *buf, int &len, int &decimal_exponent) {
+    const uint64_t hidden_bit = uint64_t(1) << 52;
+    const uint64_t bits = double_to_bits(value);
+    const int biased_exponent = static_cast<int>(bits >> 52);
+    const uint64_t fraction = bits & (hidden_bit - 1);
+
+    // The boundaries m- and m+ of the interval that rounds to v, at twice v's precision.
+    const DiyFp v = biased_exponent == 0 ? DiyFp(fraction, 1 - 1075)
+                                         : DiyFp(fraction + hidden_bit, biased_exponent - 1075);
+    const bool lower_is_closer = fraction == 0 && biased_exponent > 1;
+    const DiyFp m_plus = DiyFp(2 * v.f + 1, v.e - 1).normalized();
+    DiyFp m_minus = lower_is_closer ? DiyFp(4 * v.f - 1, v.e - 2) : DiyFp(2 * v.f - 1, v.e - 1);
+    m_minus = DiyFp(m_minus.f << (m_minus.e - m_plus.e), m_plus.e);
+    const DiyFp w = v.normalized();
+
+    // Scale by a power of ten c = 10^k that brings the exponent into [-60, -32].
+    const int f = -60 - m_plus.e - 1;
+    const int k = (f * 78913) / (1 << 18) + static_cast<int>(f > 0);
+    const uint64_t *pow10 = pow10_significands[k - pow10_min_exponent];
+    const DiyFp c(pow10[0] + (pow10[1] >> 63), floor_log2_pow10(k) - 63);
+
+    const DiyFp w_scaled = DiyFp(w.f << (w.e - m_plus.e), m_plus.e) * c;
+    const DiyFp upper = m_plus * c;
+    const DiyFp lower = m_minus * c;
+    decimal_exponent = -k;
+
+    // Shrink the interval by one unit on each side to absorb the error of the products.
+    const DiyFp high(upper.f - 1, upper.e);
+    const DiyFp low(lower.f + 1, lower.e);
+    uint64_t delta = (high - low).f;
+    uint64_t dist = (high - w_scaled).f;
+
+    const DiyFp one(uint64_t(1) << -high.e, high.e);
+    uint32_t p1 = static_cast<uint32_t>(high.f >> -one.e);
+    uint64_t p2 = high.f & (one.f - 1);
+
+    // Integral digits
+    uint32_t pow10_32 = 1;
+    int n = 1;
+    while (n < 10 && p1 >= pow10_32 * 10) {
+        pow10_32 *= 10;
+        n++;
+    }
+
+    len = 0;
+    while (n > 0) {
+        buf[len++] = static_cast<char>('0' + p1 / pow10_32);
+        p1 %= pow10_32;
+        n--;
+        const uint64_t rest = (static_cast<uint64_t>(p1) << -one.e) + p2;
+        if (rest <= delta) {
+            decimal_exponent += n;
+            grisu2_round(buf, len, dist, delta, rest, static_cast<uint64_t>(pow10_32) << -one.e);
+            return;
+        }
+        pow10_32 /= 10;
+    }
+
+    // Fractional digits
+    int m = 0;
+    while (true) {
+        p2 *= 10;
+        buf[len++] = static_cast<char>('0' + (p2 >> -one.e));
+        p2 &= one.f - 1;
+        m++;
+        delta *= 10;
+        dist *= 10;
+        if (p2 <= delta)
+            break;
+    }
+    decimal_exponent -= m;
+    grisu2_round(buf, len, dist, delta, p2, one.f);
+}
+
+/* format_int(value, buf)
+ *
+ * Write value in decimal to buf, which must hold at least 11 characters, and return the
+ * number of characters written.
+ */
+static size_t format_int(int value, char *buf) {
+    char digits[10];
+    int n = 0;
+    uint32_t magnitude = value < 0 ? 0u - static_cast<uint32_t>(value) : static_cast<uint32_t>(value);
+    do {
+        digits[n++] = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+
+    size_t len = 0;
+    if (value < 0)
+        buf[len++] = '-';
+    while (n > 0)
+        buf[len++] = digits[--n];
+    return len;
+}
+
+/* format_double(value, buf)
+ *
+ * Write a finite value to buf, which must hold at least 32 characters, and return the number
+ * of characters written. Like printf's %g, this uses plain notation for decimal exponents
+ * from -4 to 16 and scientific notation ("1.5e+300") otherwise.
+ */
+static size_t format_double(double value, char *buf) {
+    size_t len = 0;
+    if (std::signbit(value)) {
+        buf[len++] = '-';
+        value = -value;
+    }
+    if (value == 0) {
+        buf[len++] = '0';
+        return len;
+    }
+
+    char digits[18];
+    int n, decimal_exponent;
+    grisu2(value, digits, n, decimal_exponent);
+
+    // The value is 0.d1d2...dn * 10^point.
+    const int point = n + decimal_exponent;
+    if (point > -4 && point <= 17) {
+        if (point <= 0) {
+            buf[len++] = '0';
+            buf[len++] = '.';
+            for (int j = point; j < 0; j++)
+                buf[len++] = '0';
+            std::memcpy(buf + len, digits, n);
+            len += n;
+        } else if (point >= n) {
+            std::memcpy(buf + len, digits, n);
+            len += n;
+            for (int j = n; j < point; j++)
+                buf[len++] = '0';
+        } else {
+            std::memcpy(buf + len, digits, point);
+            len += point;
+            buf[len++] = '.';
+            std::memcpy(buf + len, digits + point, n - point);
+            len += n - point;
+        }
+        return len;
+    }
+
+    buf[len++] = digits[0];
+    if (n > 1) {
+        buf[len++] = '.';
+        std::memcpy(buf + len, digits + 1, n - 1);
+        len += n - 1;
+    }
+    int exponent = point - 1;
+    buf[len++] = 'e';
+    buf[len++] = exponent < 0 ? '-' : '+';
+    if (exponent < 0)
+        exponent = -exponent;
+    if (exponent >= 100)
+        buf[len++] = static_cast<char>('0' + exponent / 100);
+    buf[len++] = static_cast<char>('0' + exponent / 10 % 10);
+    buf[len++] = static_cast<char>('0' + exponent % 10);
+    return len;
+}
+
+/* * * * * * * * * * * * * * * * * * * *
+ * Scanning
+ *
+ * The hot loops of the parser and serializer look for the end of a run of "uninteresting"
+ * bytes. Where the target has 128-bit SIMD (SSE2 on x86, which every x86-64 CPU has, or NEON
+ * on AArch64) they test 16 bytes per step; the scalar loops handle the tail and other targets.
+ */
+
+static inline bool is_whitespace(char c) {
+    return c == ' ' || c == '\r' || c == '\n' || c == '\t';
+}
+
+static inline bool is_string_special(char c) {
+    return c == '"' || c == '\\' || static_cast<uint8_t>(c) < 0x20;
+}
+
+// 0xe2 leads U+2028 and U+2029, which the serializer escapes for the sake of Javascript.
+static inline bool is_escape_special(char c) {
+    return is_string_special(c) || static_cast<uint8_t>(c) == 0xe2;
+}
+
+#if JSON11_USE_SSE2
+static inline int first_set_bit(unsigned mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+#endif
+
+/* skip_whitespace(p, end)
+ *
+ * Return a pointer to the first non-whitespace character in [p, end), or end.
+ */
+static inline const char * skip_whitespace(const char *p, const char *end) {
+    // Most runs are empty or a single space, so look before setting up a vector loop.
+    if (p == end || !is_whitespace(*p))
+        return p;
+#if JSON11_USE_SSE2
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i tab = _mm_set1_epi8('\t');
+    while (end - p >= 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        const __m128i ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, cr)),
+                                        _mm_or_si128(_mm_cmpeq_epi8(v, lf), _mm_cmpeq_epi8(v, tab)));
+        const unsigned mask = ~static_cast<unsigned>(_mm_movemask_epi8(ws)) & 0xffff;
+        if (mask)
+            return p + first_set_bit(mask);
+        p += 16;
+    }
+#elif JSON11_USE_NEON
+    const uint8x16_t space = vdupq_n_u8(' ');
+    const uint8x16_t cr = vdupq_n_u8('\r');
+    const uint8x16_t lf = vdupq_n_u8('\n');
+    const uint8x16_t tab = vdupq_n_u8('\t');
+    while (end - p >= 16) {
+        const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(p));
+        const uint8x16_t ws = vorrq_u8(vorrq_u8(vceqq_u8(v, space), vceqq_u8(v, cr)),
+                                       vorrq_u8(vceqq_u8(v, lf), vceqq_u8(v, tab)));
+        if (vminvq_u8(ws) != 0xff)
+            break;
+        p += 16;
+    }
+#endif
+    while (p != end && is_whitespace(*p))
+        p++;
+    return p;
+}
+
+/* scan_string(p, end)
+ *
+ * Return a pointer to the first quote, backslash or control character in [p, end), or end.
+ */
+static inline const char * scan_string(const char *p, const char *end) {
+#if JSON11_USE_SSE2
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1f);
+    while (end - p >= 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        // max(v, 0x1f) == 0x1f exactly when v <= 0x1f as an unsigned byte.
+        const __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+            _mm_cmpeq_epi8(_mm_max_epu8(v, control), control));
+        const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(special));
+        if (mask)
+            return p + first_set_bit(mask);
+        p += 16;
+    }
+#elif JSON11_USE_NEON
+    const uint8x16_t quote = vdupq_n_u8('"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    const uint8x16_t control = vdupq_n_u8(0x20);
+    while (end - p >= 16) {
+        const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(p));
+        const uint8x16_t special = vorrq_u8(vorrq_u8(vceqq_u8(v, quote), vceqq_u8(v, backslash)),
+                                            vcltq_u8(v, control));
+        if (vmaxvq_u8(special))
+            break;
+        p += 16;
+    }
+#endif
+    while (p != end && !is_string_special(*p))
+        p++;
+    return p;
+}
+
+/* scan_escape(p, end)
+ *
+ * Return a pointer to the first byte in [p, end) that dump may need to escape, or end.
+ */
+static inline const char * scan_escape(const char *p, const char *end) {
+#if JSON11_USE_SSE2
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1f);
+    const __m128i lead = _mm_set1_epi8(static_cast<char>(0xe2));
+    while (end - p >= 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        const __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+            _mm_or_si128(_mm_cmpeq_epi8(_mm_max_epu8(v, control), control),
+                         _mm_cmpeq_epi8(v, lead)));
+        const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(special));
+        if (mask)
+            return p + first_set_bit(mask);
+        p += 16;
+    }
+#elif JSON11_USE_NEON
+    const uint8x16_t quote = vdupq_n_u8('"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    const uint8x16_t control = vdupq_n_u8(0x20);
+    const uint8x16_t lead = vdupq_n_u8(0xe2);
+    while (end - p >= 16) {
+        const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(p));
+        const uint8x16_t special = vorrq_u8(vorrq_u8(vceqq_u8(v, quote), vceqq_u8(v, backslash)),
+                                            vorrq_u8(vcltq_u8(v, control), vceqq_u8(v, lead)));
+        if (vmaxvq_u8(special))
+            break;
+        p += 16;
+    }
+#endif
+    while (p != end && !is_escape_special(*p))
+        p++;
+    return p;
+}
+
 /* * * * * * * * * * * * * * * * * * * *
  * Serialization
  */
 
-static void dump(std::nullptr_t, string &out) {
+/* JsonWriter
+ *
+ * The output of a dump. Either appends straight to a std::string, or collects the output in a
+ * fixed buffer that is handed to a JsonSink whenever it fills up. Only a sink writer has the
+ * buffer, on the heap, so string writers stay small enough to nest deeply on any stack.
+ */
+class JsonWriter final {
+public:
+    explicit JsonWriter(string &out, const Json::DumpOptions *options = nullptr)
+        : m_string(&out), m_sink(nullptr), m_pos(nullptr), m_options(options), m_depth(0) {}
+    explicit JsonWriter(JsonSink &sink, const Json::DumpOptions *options = nullptr)
+        : m_string(nullptr), m_sink(&sink), m_buffer(new char[buffer_size]), m_pos(m_buffer.get()),
+          m_options(options), m_depth(0) {}
+
+    JsonWriter(const JsonWriter &) = delete;
+    JsonWriter & operator=(const JsonWriter &) = delete;
+
+    void append(const char *data, size_t len) {
+        if (m_string) {
+            m_string->append(data, len);
+        } else if (len <= static_cast<size_t>(m_buffer.get() + buffer_size - m_pos)) {
+            memcpy(m_pos, data, len);
+            m_pos += len;
+        } else {
+            flush();
+            if (len < buffer_size) {
+                memcpy(m_pos, data, len);
+                m_pos += len;
+            } else {
+                m_sink->write(data, len);
+            }
+        }
+    }
+    JsonWriter & operator+=(const char *str) {
+        append(str, strlen(str));
+        return *this;
+    }
+    JsonWriter & operator+=(char ch) {
+        if (m_string) {
+            *m_string += ch;
+        } else {
+            if (m_pos == m_buffer.get() + buffer_size)
+                flush();
+            *m_pos++ = ch;
+        }
+        return *this;
+    }
+
+    // Serialize a value.
+    void write(const Json &value);
+
+    // True if this dump has the layout of dump(), which caches and fragments depend on.
+    bool default_layout() const { return !m_options; }
+
+    /* begin_items(), next_item(first), end_items(empty), key_separator()
+     *
+     * The layout between the brackets of an array or object, when !default_layout().
+     */
+    void begin_items() { m_depth++; }
+    void next_item(bool first) {
+        if (!first)
+            *this += (m_options->compact || m_options->indent) ? "," : ", ";
+        if (m_options->indent)
+            newline();
+    }
+    void end_items(bool empty) {
+        m_depth--;
+        if (m_options->indent && !empty)
+            newline();
+    }
+    const char *key_separator() const { return m_options->compact ? ":" : ": "; }
+
+    // Serialize a value as CBOR.
+    void write_cbor(const Json &value);
+
+    // Pass any buffered output on to the sink.
+    void flush() {
+        if (m_pos != m_buffer.get())
+            m_sink->write(m_buffer.get(), static_cast<size_t>(m_pos - m_buffer.get()));
+        m_pos = m_buffer.get();
+    }
+
+private:
+    void newline() {
+        static const char spaces[] = "                                ";
+        *this += '\n';
+        for (size_t n = static_cast<size_t>(m_depth) * m_options->indent; n > 0; ) {
+            const size_t chunk = std::min(n, sizeof spaces - 1);
+            append(spaces, chunk);
+            n -= chunk;
+        }
+    }
+
+    static const size_t buffer_size = 16 * 1024;
+
+    string * const m_string;
+    JsonSink * const m_sink;
+    const std::unique_ptr<char[]> m_buffer;
+    char * m_pos;
+    const Json::DumpOptions * const m_options;
+    int m_depth;
+};
+
+// Nested dumps (of cached and fragment children) each put a writer on the stack.
+static_assert(sizeof(JsonWriter) <= 64, "string writers must stay small");
+
+static void dump(std::nullptr_t, JsonWriter &out) {
     out += "null";
 }
 
-static void dump(double value, string &out) {
+static void dump(double value, JsonWriter &out) {
     if (std::isfinite(value)) {
         char buf[32];
-        snprintf(buf, sizeof buf, "%.17g", value);
-        out += buf;
+        out.append(buf, format_double(value, buf));
     } else {
         out += "null";
     }
 }
 
-static void dump(int value, string &out) {
-    char buf[32];
-    snprintf(buf, sizeof buf, "%d", value);
-    out += buf;
+static void dump(int value, JsonWriter &out) {
+    char buf[16];
+    out.append(buf, format_int(value, buf));
 }
 
-static void dump(bool value, string &out) {
+static void dump(bool value, JsonWriter &out) {
     out += value ? "true" : "false";
 }
 
-static void dump(const string &value, string &out) {
+// The escapes for bytes 0x00-0x1f: the short form where JSON has one, \u00XX otherwise.
+static const char control_escapes[32][7] = {
+    "\\u0000", "\\u0001", "\\u0002", "\\u0003", "\\u0004", "\\u0005", "\\u0006", "\\u0007",
+    "\\b",     "\\t",     "\\n",     "\\u000b", "\\f",     "\\r",     "\\u000e", "\\u000f",
+    "\\u0010", "\\u0011", "\\u0012", "\\u0013", "\\u0014", "\\u0015", "\\u0016", "\\u0017",
+    "\\u0018", "\\u0019", "\\u001a", "\\u001b", "\\u001c", "\\u001d", "\\u001e", "\\u001f",
+};
+
+// The string of length bytes at data, which need not be owned by a std::string.
+static void dump(const char *data, size_t length, JsonWriter &out) {
     out += '"';
-    for (size_t i = 0; i < value.length(); i++) {
-        const char ch = value[i];
+    const char *p = data;
+    const char *end = p + length;
+    for (;;) {
+        const char *run_end = scan_escape(p, end);
+        out.append(p, static_cast<size_t>(run_end - p));
+        if (run_end == end)
+            break;
+        p = run_end;
+        const uint8_t ch = static_cast<uint8_t>(*p);
         if (ch == '\\') {
-            out += "\\\\";
+            out.append("\\\\", 2);
         } else if (ch == '"') {
-            out += "\\\"";
-        } else if (ch == '\b') {
-            out += "\\b";
-        } else if (ch == '\f') {
-            out += "\\f";
-        } else if (ch == '\n') {
-            out += "\\n";
-        } else if (ch == '\r') {
-            out += "\\r";
-        } else if (ch == '\t') {
-            out += "\\t";
-        } else if (static_cast<uint8_t>(ch) <= 0x1f) {
-            char buf[8];
-            snprintf(buf, sizeof buf, "\\u%04x", ch);
-            out += buf;
-        } else if (static_cast<uint8_t>(ch) == 0xe2 && static_cast<uint8_t>(value[i+1]) == 0x80
-                   && static_cast<uint8_t>(value[i+2]) == 0xa8) {
-            out += "\\u2028";
-            i += 2;
-        } else if (static_cast<uint8_t>(ch) == 0xe2 && static_cast<uint8_t>(value[i+1]) == 0x80
-                   && static_cast<uint8_t>(value[i+2]) == 0xa9) {
-            out += "\\u2029";
-            i += 2;
+            out.append("\\\"", 2);
+        } else if (ch < 0x20) {
+            const char *escape = control_escapes[ch];
+            out.append(escape, escape[1] == 'u' ? 6 : 2);
+        } else if (end - p >= 3 && static_cast<uint8_t>(p[1]) == 0x80
+                   && (static_cast<uint8_t>(p[2]) == 0xa8 || static_cast<uint8_t>(p[2]) == 0xa9)) {
+            out.append(static_cast<uint8_t>(p[2]) == 0xa8 ? "\\u2028" : "\\u2029", 6);
+            p += 2;
         } else {
-            out += ch;
+            out += *p;
         }
+        p++;
     }
     out += '"';
 }
 
-static void dump(const Json::array &values, string &out) {
+static void dump(const string &value, JsonWriter &out) {
+    dump(value.data(), value.size(), out);
+}
+
+static void dump(const Json::array &values, JsonWriter &out) {
+    if (!out.default_layout()) {
+        out += "[";
+        out.begin_items();
+        for (size_t k = 0; k < values.size(); k++) {
+            out.next_item(k == 0);
+            out.write(values[k]);
+        }
+        out.end_items(values.empty());
+        out += "]";
+        return;
+    }
+
     bool first = true;
     out += "[";
     for (const auto &value : values) {
         if (!first)
             out += ", ";
-        value.dump(out);
+        out.write(value);
         first = false;
     }
     out += "]";
 }
 
-static void dump(const Json::object &values, string &out) {
+static void dump(const Json::object &values, JsonWriter &out) {
+    if (!out.default_layout()) {
+        bool first = true;
+        out += "{";
+        out.begin_items();
+        for (const auto &kv : values) {
+            out.next_item(first);
+            dump(kv.first, out);
+            out += out.key_separator();
+            out.write(kv.second);
+            first = false;
+        }
+        out.end_items(values.empty());
+        out += "}";
+        return;
+    }
+
     bool first = true;
     out += "{";
     for (const auto &kv : values) {
@@ -122,14 +1520,157 @@ static void dump(const Json::object &values, string &out) {
             out += ", ";
         dump(kv.first, out);
         out += ": ";
-        kv.second.dump(out);
+        out.write(kv.second);
         first = false;
     }
     out += "}";
 }
 
+/* serialized_size(value)
+ *
+ * The number of bytes that dump(value, out) appends, computed without producing them.
+ */
+static size_t serialized_size(std::nullptr_t) {
+    return 4;
+}
+
+static size_t serialized_size(double value) {
+    char buf[32];
+    return std::isfinite(value) ? format_double(value, buf) : 4;
+}
+
+static size_t serialized_size(int value) {
+    char buf[16];
+    return format_int(value, buf);
+}
+
+static size_t serialized_size(bool value) {
+    return value ? 4 : 5;
+}
+
+static size_t serialized_size(const char *data, size_t length) {
+    size_t size = length + 2;
+    const char *p = data;
+    const char *end = p + length;
+    while ((p = scan_escape(p, end)) != end) {
+        const uint8_t ch = static_cast<uint8_t>(*p);
+        if (ch == '\\' || ch == '"') {
+            size += 1;
+        } else if (ch < 0x20) {
+            size += control_escapes[ch][1] == 'u' ? 5 : 1;
+        } else if (end - p >= 3 && static_cast<uint8_t>(p[1]) == 0x80
+                   && (static_cast<uint8_t>(p[2]) == 0xa8 || static_cast<uint8_t>(p[2]) == 0xa9)) {
+            size += 3;
+            p += 2;
+        }
+        p++;
+    }
+    return size;
+}
+
+static size_t serialized_size(const string &value) {
+    return serialized_size(value.data(), value.size());
+}
+
+static size_t serialized_size(const Json::array &values) {
+    size_t size = values.empty() ? 2 : 2 * values.size();
+    for (const auto &value : values)
+        size += value.serialized_size();
+    return size;
+}
+
+static size_t serialized_size(const Json::object &values) {
+    size_t size = values.empty() ? 2 : 2 * values.size();
+    for (const auto &kv : values)
+        size += serialized_size(kv.first) + 2 + kv.second.serialized_size();
+    return size;
+}
+
+size_t Json::serialized_size() const {
+    switch (m_repr) {
+    case REPR_VALUE:  return m_ptr->serialized_size();
+    case REPR_NULL:   return json11::serialized_size(nullptr);
+    case REPR_BOOL:   return json11::serialized_size(m_bool);
+    case REPR_INT:    return json11::serialized_size(m_int);
+    case REPR_DOUBLE: return json11::serialized_size(m_double);
+    }
+    return 0;
+}
+
+// Dump cache budget, see Json::set_dump_cache_limit.
+static std::atomic<size_t> dump_cache_limit(0);
+static std::atomic<size_t> dump_cache_used(0);
+
+void Json::set_dump_cache_limit(size_t bytes) {
+    dump_cache_limit.store(bytes, std::memory_order_relaxed);
+}
+
+size_t Json::dump_cache_size() {
+    return dump_cache_used.load(std::memory_order_relaxed);
+}
+
+void JsonWriter::write(const Json &value) {
+    switch (value.m_repr) {
+    case Json::REPR_VALUE:
+        if (value.m_ptr.use_count() > 1 && default_layout()
+                && dump_cache_limit.load(std::memory_order_relaxed))
+            value.m_ptr->dump_shared(*this);
+        else
+            value.m_ptr->dump(*this);
+        break;
+    case Json::REPR_NULL:   json11::dump(nullptr, *this);         break;
+    case Json::REPR_BOOL:   json11::dump(value.m_bool, *this);    break;
+    case Json::REPR_INT:    json11::dump(value.m_int, *this);     break;
+    case Json::REPR_DOUBLE: json11::dump(value.m_double, *this);  break;
+    }
+}
+
 void Json::dump(string &out) const {
-    m_ptr->dump(out);
+    if (m_repr == REPR_VALUE) {
+        if (const size_t size = m_ptr->known_size())
+            out.reserve(out.size() + size);
+    }
+    JsonWriter writer(out);
+    writer.write(*this);
+}
+
+#ifdef JSON11_STATS
+void Json::dump(string &out, Stats &stats) const {
+    const auto start = std::chrono::steady_clock::now();
+    const size_t before = out.size();
+    dump(out);
+    stats.dumped_bytes += out.size() - before;
+    stats.dump_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+#endif
+
+void Json::dump(JsonSink &sink) const {
+    JsonWriter writer(sink);
+    writer.write(*this);
+    writer.flush();
+}
+
+void Json::dump(string &out, const DumpOptions &options) const {
+    if (!options.compact && !options.indent)
+        return dump(out);
+    JsonWriter writer(out, &options);
+    writer.write(*this);
+}
+
+void Json::dump(JsonSink &sink, const DumpOptions &options) const {
+    if (!options.compact && !options.indent)
+        return dump(sink);
+    JsonWriter writer(sink, &options);
+    writer.write(*this);
+    writer.flush();
+}
+
+void JsonFileSink::write(const char *data, size_t len) {
+    fwrite(data, 1, len, m_file);
+}
+
+void JsonStreamSink::write(const char *data, size_t len) {
+    m_stream.write(data, static_cast<std::streamsize>(len));
 }
 
 /* * * * * * * * * * * * * * * * * * * *
@@ -157,72 +1698,350 @@ protected:
         return m_value < static_cast<const Value<tag, T> *>(other)->m_value;
     }
 
-    const T m_value;
-    void dump(string &out) const override { json11::dump(m_value, out); }
-};
-
-class JsonDouble final : public Value<Json::NUMBER, double> {
-    double number_value() const override { return m_value; }
-    int int_value() const override { return static_cast<int>(m_value); }
-    bool equals(const JsonValue * other) const override { return m_value == other->number_value(); }
-    bool less(const JsonValue * other)   const override { return m_value <  other->number_value(); }
-public:
-    explicit JsonDouble(double value) : Value(value) {}
-};
-
-class JsonInt final : public Value<Json::NUMBER, int> {
-    double number_value() const override { return m_value; }
-    int int_value() const override { return m_value; }
-    bool equals(const JsonValue * other) const override { return m_value == other->number_value(); }
-    bool less(const JsonValue * other)   const override { return m_value <  other->number_value(); }
-public:
-    explicit JsonInt(int value) : Value(value) {}
-};
-
-class JsonBoolean final : public Value<Json::BOOL, bool> {
-    bool bool_value() const override { return m_value; }
-public:
-    explicit JsonBoolean(bool value) : Value(value) {}
+    T m_value;
+    void dump(JsonWriter &out) const override { json11::dump(m_value, out); }
+    size_t serialized_size() const override { return json11::serialized_size(m_value); }
 };
 
 class JsonString final : public Value<Json::STRING, string> {
     const string &string_value() const override { return m_value; }
+    string *mutable_string() override { return &m_value; }
+    bool equals(const JsonValue * other) const override { return m_value == other->string_value(); }
+    bool less(const JsonValue * other)   const override { return m_value <  other->string_value(); }
 public:
     explicit JsonString(const string &value) : Value(value) {}
     explicit JsonString(string &&value)      : Value(move(value)) {}
 };
 
-class JsonArray final : public Value<Json::ARRAY, Json::array> {
-    const Json::array &array_items() const override { return m_value; }
-    const Json & operator[](size_t i) const override;
-public:
-    explicit JsonArray(const Json::array &value) : Value(value) {}
-    explicit JsonArray(Json::array &&value)      : Value(move(value)) {}
-};
-
-class JsonObject final : public Value<Json::OBJECT, Json::object> {
-    const Json::object &object_items() const override { return m_value; }
-    const Json & operator[](const string &key) const override;
-public:
-    explicit JsonObject(const Json::object &value) : Value(value) {}
-    explicit JsonObject(Json::object &&value)      : Value(move(value)) {}
-};
+/* JsonStringView
+ *
+ * A string value that refers to (still escaped) text in the parser's input, produced by
+ * Json::parse_view. It is decoded into an owned std::string the first time it is read. Text
+ * without escapes is already its own value, so dumping and sizing it read the input directly.
+ */
+class JsonStringView final : public JsonValue {
+    Json::Type type() const override { return Json::STRING; }
+    const string &string_value() const override;
+    bool equals(const JsonValue * other) const override { return string_value() == other->string_value(); }
+    bool less(const JsonValue * other)   const override { return string_value() <  other->string_value(); }
+    void dump(JsonWriter &out) const override {
+        if (m_escaped)
+            json11::dump(string_value(), out);
+        else
+            json11::dump(m_data, m_length, out);
+    }
+    size_t serialized_size() const override {
+        return m_escaped ? json11::serialized_size(string_value())
+                         : json11::serialized_size(m_data, m_length);
+    }
 
-class JsonNull final : public Value<Json::NUL, std::nullptr_t> {
+    const char * const m_data;
+    const size_t m_length;
+    const bool m_escaped;
+    mutable std::once_flag m_once;
+    mutable string m_value;
 public:
-    JsonNull() : Value(nullptr) {}
+    JsonStringView(const char *data, size_t length, bool escaped)
+        : m_data(data), m_length(length), m_escaped(escaped) {}
+};
+
+/* hash_combine(seed, hash), hash_items(items)
+ *
+ * Fold the hashes of the items of an array or object, in order, into one.
+ */
+static size_t hash_combine(size_t seed, size_t hash) {
+    return seed ^ (hash + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
+static size_t hash_items(const Json::array &items) {
+    size_t seed = items.size();
+    for (const Json &item : items)
+        seed = hash_combine(seed, item.hash());
+    return seed;
+}
+
+static size_t hash_items(const Json::object &items) {
+    size_t seed = ~items.size();
+    for (const auto &item : items)
+        seed = hash_combine(hash_combine(seed, std::hash<string>()(item.first)), item.second.hash());
+    return seed;
+}
+
+/* SizeCache
+ *
+ * The serialized size of an array or object, computed the first time it is asked for. A node
+ * only changes while it has a single owner, which resets the cache, so racing readers can
+ * only ever store the same value. 0 means unknown; no container serializes to fewer than two
+ * bytes.
+ */
+class SizeCache {
+public:
+    SizeCache() : m_size(0) {}
+    template <typename T>
+    size_t get(const T &value) const {
+        size_t size = m_size.load(std::memory_order_relaxed);
+        if (!size) {
+            size = json11::serialized_size(value);
+            m_size.store(size, std::memory_order_relaxed);
+        }
+        return size;
+    }
+    size_t known() const { return m_size.load(std::memory_order_relaxed); }
+    void reset() { m_size.store(0, std::memory_order_relaxed); }
+private:
+    mutable std::atomic<size_t> m_size;
+};
+
+/* HashCache
+ *
+ * The hash of an array or object, computed the first time it is asked for, under the same
+ * rules as SizeCache. 0 means unknown, so a computed 0 is stored as 1.
+ */
+class HashCache {
+public:
+    HashCache() : m_hash(0) {}
+    template <typename T>
+    size_t get(const T &value) const {
+        size_t hash = m_hash.load(std::memory_order_relaxed);
+        if (!hash) {
+            hash = hash_items(value);
+            hash += !hash;
+            m_hash.store(hash, std::memory_order_relaxed);
+        }
+        return hash;
+    }
+    size_t known() const { return m_hash.load(std::memory_order_relaxed); }
+    void reset() { m_hash.store(0, std::memory_order_relaxed); }
+private:
+    mutable std::atomic<size_t> m_hash;
+};
+
+/* DumpCache
+ *
+ * The serialized bytes of an array or object, saved by its first dump_shared that fits in the
+ * dump cache budget. The first thread to publish its copy wins; the others discard theirs.
+ */
+class DumpCache {
+public:
+    DumpCache() : m_bytes(nullptr) {}
+    ~DumpCache() { reset(); }
+
+    void reset() {
+        if (const string *bytes = m_bytes.exchange(nullptr, std::memory_order_relaxed)) {
+            dump_cache_used.fetch_sub(bytes->size(), std::memory_order_relaxed);
+            delete bytes;
+        }
+    }
+
+    DumpCache(const DumpCache &) = delete;
+    DumpCache & operator=(const DumpCache &) = delete;
+
+    template <typename T>
+    void dump(const T &value, size_t size, JsonWriter &out) const {
+        const string *bytes = m_bytes.load(std::memory_order_acquire);
+        if (!bytes) {
+            const size_t used = dump_cache_used.fetch_add(size, std::memory_order_relaxed);
+            if (used + size > dump_cache_limit.load(std::memory_order_relaxed)) {
+                dump_cache_used.fetch_sub(size, std::memory_order_relaxed);
+                json11::dump(value, out);
+                return;
+            }
+            string *fresh = new string;
+            fresh->reserve(size);
+            {
+                JsonWriter writer(*fresh);
+                json11::dump(value, writer);
+            }
+            const string *expected = nullptr;
+            if (m_bytes.compare_exchange_strong(expected, fresh, std::memory_order_acq_rel)) {
+                bytes = fresh;
+            } else {
+                dump_cache_used.fetch_sub(size, std::memory_order_relaxed);
+                delete fresh;
+                bytes = expected;
+            }
+        }
+        out.append(bytes->data(), bytes->size());
+    }
+
+private:
+    mutable std::atomic<const string *> m_bytes;
+};
+
+class JsonArray final : public Value<Json::ARRAY, Json::array> {
+    const Json::array &array_items() const override { return m_value; }
+    bool equals(const JsonValue * other) const override { return m_value == other->array_items(); }
+    bool less(const JsonValue * other)   const override { return m_value <  other->array_items(); }
+    const Json & operator[](size_t i) const override;
+    size_t serialized_size() const override { return m_size.get(m_value); }
+    void dump_shared(JsonWriter &out) const override {
+        m_dump.dump(m_value, serialized_size(), out);
+    }
+    size_t hash() const override { return m_hash.get(m_value); }
+    size_t known_hash() const override { return m_hash.known(); }
+    size_t known_size() const override { return m_size.known(); }
+    Json::array *mutable_array() override {
+        m_size.reset();
+        m_dump.reset();
+        m_hash.reset();
+        return &m_value;
+    }
+    SizeCache m_size;
+    DumpCache m_dump;
+    HashCache m_hash;
+public:
+    explicit JsonArray(const Json::array &value) : Value(value) {}
+    explicit JsonArray(Json::array &&value)      : Value(move(value)) {}
+};
+
+class JsonObject final : public Value<Json::OBJECT, Json::object> {
+    const Json::object &object_items() const override { return m_value; }
+    bool equals(const JsonValue * other) const override { return m_value == other->object_items(); }
+    bool less(const JsonValue * other)   const override { return m_value <  other->object_items(); }
+    const Json & operator[](const string &key) const override;
+    size_t serialized_size() const override { return m_size.get(m_value); }
+    void dump_shared(JsonWriter &out) const override {
+        m_dump.dump(m_value, serialized_size(), out);
+    }
+    size_t hash() const override { return m_hash.get(m_value); }
+    size_t known_hash() const override { return m_hash.known(); }
+    size_t known_size() const override { return m_size.known(); }
+    Json::object *mutable_object() override {
+        m_size.reset();
+        m_dump.reset();
+        m_hash.reset();
+        return &m_value;
+    }
+    SizeCache m_size;
+    DumpCache m_dump;
+    HashCache m_hash;
+public:
+    explicit JsonObject(const Json::object &value) : Value(value) {}
+    explicit JsonObject(Json::object &&value)      : Value(move(value)) {}
+};
+
+/* JsonFragment
+ *
+ * A string, array or object made by Json::fragment, which dumps as the bytes it was
+ * serialized to when it was made and answers everything else from the value itself.
+ */
+class JsonFragment final : public JsonValue {
+    Json::Type type() const override { return m_value.type(); }
+    bool equals(const JsonValue * other) const override {
+        switch (m_value.type()) {
+        case Json::STRING: return m_value.string_value() == other->string_value();
+        case Json::ARRAY:  return m_value.array_items() == other->array_items();
+        default:           return m_value.object_items() == other->object_items();
+        }
+    }
+    bool less(const JsonValue * other) const override {
+        switch (m_value.type()) {
+        case Json::STRING: return m_value.string_value() < other->string_value();
+        case Json::ARRAY:  return m_value.array_items() < other->array_items();
+        default:           return m_value.object_items() < other->object_items();
+        }
+    }
+    void dump(JsonWriter &out) const override {
+        if (out.default_layout())
+            out.append(m_bytes.data(), m_bytes.size());
+        else
+            out.write(m_value);
+    }
+    size_t serialized_size() const override { return m_bytes.size(); }
+    size_t hash() const override { return m_hash; }
+    size_t known_hash() const override { return m_hash; }
+    size_t known_size() const override { return m_bytes.size(); }
+    const string &string_value() const override { return m_value.string_value(); }
+    const Json::array &array_items() const override { return m_value.array_items(); }
+    const Json &operator[](size_t i) const override { return m_value[i]; }
+    const Json::object &object_items() const override { return m_value.object_items(); }
+    const Json &operator[](const string &key) const override { return m_value[key]; }
+
+    const Json m_value;
+    const string m_bytes;
+    const size_t m_hash;
+public:
+    explicit JsonFragment(Json value)
+        : m_value(move(value)), m_bytes(m_value.dump()), m_hash(m_value.hash() + !m_value.hash()) {}
+};
+
+/* LazyDocument
+ *
+ * The input of Json::parse_lazy and its structural index: the extent of every array and
+ * object, in document order. Shared by all the lazy nodes of one parse.
+ */
+struct LazyDocument {
+    struct Container {
+        size_t end;         // Offset just past the closing bracket
+        size_t next;        // Index of the next container that is not inside this one
+    };
+
+    const char *str;
+    size_t len;
+    vector<Container> containers;
+};
+
+/* JsonLazyArray, JsonLazyObject
+ *
+ * An array or object of a Json::parse_lazy document, which parses its own level of the input
+ * into items (strings and scalars, and lazy nodes for nested containers) the first time it is
+ * read. Editing goes through a copy, since mutable_array and mutable_object return null.
+ */
+template <Json::Type tag, typename T>
+class LazyContainer : public JsonValue {
+protected:
+    LazyContainer(std::shared_ptr<const LazyDocument> doc, size_t start, size_t container)
+        : m_doc(std::move(doc)), m_start(start), m_container(container) {}
+
+    Json::Type type() const override { return tag; }
+    void dump(JsonWriter &out) const override { json11::dump(items(), out); }
+    size_t serialized_size() const override { return m_size.get(items()); }
+    size_t hash() const override { return m_hash.get(items()); }
+    size_t known_hash() const override { return m_hash.known(); }
+    size_t known_size() const override { return m_size.known(); }
+
+    const T &items() const {
+        std::call_once(m_once, [this] { materialize(); });
+        return m_items;
+    }
+    void materialize() const;
+
+    const std::shared_ptr<const LazyDocument> m_doc;
+    const size_t m_start;       // Offset of the opening bracket
+    const size_t m_container;   // Index in m_doc->containers
+    mutable std::once_flag m_once;
+    mutable T m_items;
+    SizeCache m_size;
+    HashCache m_hash;
+};
+
+class JsonLazyArray final : public LazyContainer<Json::ARRAY, Json::array> {
+    const Json::array &array_items() const override { return items(); }
+    const Json & operator[](size_t i) const override;
+    bool equals(const JsonValue * other) const override { return items() == other->array_items(); }
+    bool less(const JsonValue * other)   const override { return items() <  other->array_items(); }
+public:
+    JsonLazyArray(std::shared_ptr<const LazyDocument> doc, size_t start, size_t container)
+        : LazyContainer(std::move(doc), start, container) {}
+};
+
+class JsonLazyObject final : public LazyContainer<Json::OBJECT, Json::object> {
+    const Json::object &object_items() const override { return items(); }
+    const Json & operator[](const string &key) const override;
+    bool equals(const JsonValue * other) const override { return items() == other->object_items(); }
+    bool less(const JsonValue * other)   const override { return items() <  other->object_items(); }
+public:
+    JsonLazyObject(std::shared_ptr<const LazyDocument> doc, size_t start, size_t container)
+        : LazyContainer(std::move(doc), start, container) {}
 };
 
 /* * * * * * * * * * * * * * * * * * * *
  * Static globals - static-init-safe
  */
 struct Statics {
-    const std::shared_ptr<JsonValue> null = make_shared<JsonNull>();
-    const std::shared_ptr<JsonValue> t = make_shared<JsonBoolean>(true);
-    const std::shared_ptr<JsonValue> f = make_shared<JsonBoolean>(false);
     const string empty_string;
     const vector<Json> empty_vector;
-    const map<string, Json> empty_map;
+    const Json::object empty_map;
     Statics() {}
 };
 
@@ -232,48 +2051,309 @@ const Statics & statics() {
 }
 
 const Json & static_null() {
-    // This has to be separate, not in Statics, because Json() accesses statics().null.
     static const Json json_null;
     return json_null;
 }
 
+/* * * * * * * * * * * * * * * * * * * *
+ * Allocation
+ */
+
+struct Arena::Block {
+    Block *next;
+    size_t size;
+};
+
+Arena::Arena(size_t block_size)
+    : m_head(nullptr), m_cur(nullptr), m_end(nullptr), m_block_size(block_size),
+      m_used(0), m_live(0) {}
+
+Arena::~Arena() {
+    // Every value taken from the arena must already be gone.
+    assert(m_live == 0);
+    while (m_head) {
+        Block *next = m_head->next;
+        ::operator delete(m_head);
+        m_head = next;
+    }
+}
+
+void * Arena::allocate(size_t size, size_t align) {
+    uintptr_t cur = (reinterpret_cast<uintptr_t>(m_cur) + align - 1) & ~(uintptr_t(align) - 1);
+    if (!m_cur || cur + size > reinterpret_cast<uintptr_t>(m_end)) {
+        // Oversized requests get a block of their own.
+        size_t block_size = std::max(m_block_size, size + align + sizeof(Block));
+        Block *block = static_cast<Block *>(::operator new(block_size));
+        block->next = m_head;
+        block->size = block_size;
+        m_head = block;
+        m_cur = reinterpret_cast<char *>(block + 1);
+        m_end = reinterpret_cast<char *>(block) + block_size;
+        cur = (reinterpret_cast<uintptr_t>(m_cur) + align - 1) & ~(uintptr_t(align) - 1);
+    }
+    m_cur = reinterpret_cast<char *>(cur + size);
+    m_used += size;
+    m_live++;
+    return reinterpret_cast<void *>(cur);
+}
+
+/* * * * * * * * * * * * * * * * * * * *
+ * Pool allocator
+ */
+
+// Free lists for JsonPoolAllocator, per thread: one for every 16 bytes up to 256.
+static const size_t pool_granularity = 16;
+static const size_t pool_classes = 16;
+static const size_t pool_max_per_class = 1024;
+
+struct PoolNode {
+    PoolNode *next;
+};
+
+struct PoolCache {
+    PoolNode *lists[pool_classes];
+    size_t counts[pool_classes];
+
+    PoolCache() : lists(), counts() {}
+    ~PoolCache();
+};
+
+// Set once this thread's cache has been destroyed, for nodes freed later during thread exit.
+static thread_local bool pool_cache_gone = false;
+
+PoolCache::~PoolCache() {
+    for (PoolNode *node : lists) {
+        while (node) {
+            PoolNode *next = node->next;
+            ::operator delete(node);
+            node = next;
+        }
+    }
+    pool_cache_gone = true;
+}
+
+static PoolCache & pool_cache() {
+    static thread_local PoolCache cache;
+    return cache;
+}
+
+void * JsonPoolAllocator::allocate(size_t size, size_t align) {
+    assert(align <= alignof(std::max_align_t));
+    (void)align;
+    const size_t index = (size - 1) / pool_granularity;
+    if (index >= pool_classes)
+        return ::operator new(size);
+    // Always the full class size, even after this thread's cache is gone: the node may be
+    // freed on another thread, into the list that later hands it out as a whole class.
+    if (pool_cache_gone)
+        return ::operator new((index + 1) * pool_granularity);
+
+    PoolCache &cache = pool_cache();
+    if (PoolNode *node = cache.lists[index]) {
+        cache.lists[index] = node->next;
+        cache.counts[index]--;
+        return node;
+    }
+    return ::operator new((index + 1) * pool_granularity);
+}
+
+void JsonPoolAllocator::deallocate(void *p, size_t size, size_t) noexcept {
+    const size_t index = (size - 1) / pool_granularity;
+    if (index >= pool_classes || pool_cache_gone) {
+        ::operator delete(p);
+        return;
+    }
+
+    PoolCache &cache = pool_cache();
+    if (cache.counts[index] == pool_max_per_class) {
+        ::operator delete(p);
+        return;
+    }
+    PoolNode *node = static_cast<PoolNode *>(p);
+    node->next = cache.lists[index];
+    cache.lists[index] = node;
+    cache.counts[index]++;
+}
+
+/* NodeAllocator<T>
+ *
+ * Standard allocator adaptor over a JsonAllocator, for use with std::allocate_shared.
+ */
+template <typename T>
+struct NodeAllocator {
+    typedef T value_type;
+
+    explicit NodeAllocator(JsonAllocator *allocator) noexcept : allocator(allocator) {}
+    template <typename U>
+    NodeAllocator(const NodeAllocator<U> &other) noexcept : allocator(other.allocator) {}
+
+    T *allocate(size_t n) {
+        return static_cast<T *>(allocator->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T *p, size_t n) noexcept {
+        allocator->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    template <typename U>
+    bool operator==(const NodeAllocator<U> &other) const { return allocator == other.allocator; }
+    template <typename U>
+    bool operator!=(const NodeAllocator<U> &other) const { return allocator != other.allocator; }
+
+    JsonAllocator *allocator;
+};
+
+// The allocator installed by Json::set_allocator, or null for std::allocator.
+static std::atomic<JsonAllocator *> default_allocator(nullptr);
+
+void Json::set_allocator(JsonAllocator *allocator) {
+    default_allocator.store(allocator, std::memory_order_release);
+}
+
+/* make_value<T>(allocator, args...)
+ *
+ * Construct a T from args, taking its storage from allocator if there is one.
+ */
+#ifdef JSON11_NONATOMIC_REFCOUNT
+template <typename T, typename... Args>
+static detail::value_ptr make_value(JsonAllocator *allocator, Args &&... args) {
+    // Frees the storage if the constructor throws.
+    struct Storage {
+        JsonAllocator *allocator;
+        void *p;
+        ~Storage() {
+            if (!p)
+                return;
+            if (allocator)
+                allocator->deallocate(p, sizeof(T), alignof(T));
+            else
+                ::operator delete(p);
+        }
+    } storage { allocator, allocator ? allocator->allocate(sizeof(T), alignof(T))
+                                     : ::operator new(sizeof(T)) };
+    T *value = new (storage.p) T(std::forward<Args>(args)...);
+    storage.p = nullptr;
+    value->m_allocator = allocator;
+    value->m_alloc_size = sizeof(T);
+    value->m_alloc_align = alignof(T);
+    return detail::value_ptr(value);
+}
+
+void destroy_value(const JsonValue *value) noexcept {
+    JsonAllocator *allocator = value->m_allocator;
+    const size_t size = value->m_alloc_size;
+    const size_t align = value->m_alloc_align;
+    void *p = const_cast<void *>(dynamic_cast<const void *>(value));
+    value->~JsonValue();
+    if (allocator)
+        allocator->deallocate(p, size, align);
+    else
+        ::operator delete(p);
+}
+#else
+template <typename T, typename... Args>
+static detail::value_ptr make_value(JsonAllocator *allocator, Args &&... args) {
+    if (allocator)
+        return std::allocate_shared<T>(NodeAllocator<T>(allocator), std::forward<Args>(args)...);
+    return make_shared<T>(std::forward<Args>(args)...);
+}
+#endif
+
+template <typename T, typename... Args>
+static detail::value_ptr make_value(Args &&... args) {
+    return make_value<T>(default_allocator.load(std::memory_order_acquire),
+                         std::forward<Args>(args)...);
+}
+
 /* * * * * * * * * * * * * * * * * * * *
  * Constructors
  */
 
-Json::Json() noexcept                  : m_ptr(statics().null) {}
-Json::Json(std::nullptr_t) noexcept    : m_ptr(statics().null) {}
-Json::Json(double value)               : m_ptr(make_shared<JsonDouble>(value)) {}
-Json::Json(int value)                  : m_ptr(make_shared<JsonInt>(value)) {}
-Json::Json(bool value)                 : m_ptr(value ? statics().t : statics().f) {}
-Json::Json(const string &value)        : m_ptr(make_shared<JsonString>(value)) {}
-Json::Json(string &&value)             : m_ptr(make_shared<JsonString>(move(value))) {}
-Json::Json(const char * value)         : m_ptr(make_shared<JsonString>(value)) {}
-Json::Json(const Json::array &values)  : m_ptr(make_shared<JsonArray>(values)) {}
-Json::Json(Json::array &&values)       : m_ptr(make_shared<JsonArray>(move(values))) {}
-Json::Json(const Json::object &values) : m_ptr(make_shared<JsonObject>(values)) {}
-Json::Json(Json::object &&values)      : m_ptr(make_shared<JsonObject>(move(values))) {}
+Json::Json() noexcept                  : m_double(0),     m_repr(REPR_NULL) {}
+Json::Json(std::nullptr_t) noexcept    : m_double(0),     m_repr(REPR_NULL) {}
+Json::Json(double value)               : m_double(value), m_repr(REPR_DOUBLE) {}
+Json::Json(int value)                  : m_int(value),    m_repr(REPR_INT) {}
+Json::Json(bool value)                 : m_bool(value),   m_repr(REPR_BOOL) {}
+Json::Json(const string &value)        : Json(make_value<JsonString>(value)) {}
+Json::Json(string &&value)             : Json(make_value<JsonString>(move(value))) {}
+Json::Json(const char * value)         : Json(make_value<JsonString>(value)) {}
+Json::Json(const Json::array &values)  : Json(make_value<JsonArray>(values)) {}
+Json::Json(Json::array &&values)       : Json(make_value<JsonArray>(move(values))) {}
+Json::Json(const Json::object &values) : Json(make_value<JsonObject>(values)) {}
+Json::Json(Json::object &&values)      : Json(make_value<JsonObject>(move(values))) {}
+
+Json Json::fragment(Json value) {
+    // Scalars are inline and already cost nothing to copy.
+    if (value.m_repr != REPR_VALUE)
+        return value;
+    return Json(make_value<JsonFragment>(move(value)));
+}
 
 /* * * * * * * * * * * * * * * * * * * *
  * Accessors
  */
 
-Json::Type Json::type()                           const { return m_ptr->type();         }
-double Json::number_value()                       const { return m_ptr->number_value(); }
-int Json::int_value()                             const { return m_ptr->int_value();    }
-bool Json::bool_value()                           const { return m_ptr->bool_value();   }
-const string & Json::string_value()               const { return m_ptr->string_value(); }
-const vector<Json> & Json::array_items()          const { return m_ptr->array_items();  }
-const map<string, Json> & Json::object_items()    const { return m_ptr->object_items(); }
-const Json & Json::operator[] (size_t i)          const { return (*m_ptr)[i];           }
-const Json & Json::operator[] (const string &key) const { return (*m_ptr)[key];         }
+Json::Type Json::type() const {
+    switch (m_repr) {
+    case REPR_VALUE:  return m_ptr->type();
+    case REPR_NULL:   return NUL;
+    case REPR_BOOL:   return BOOL;
+    case REPR_INT:    return NUMBER;
+    case REPR_DOUBLE: return NUMBER;
+    }
+    return NUL;
+}
+
+double Json::number_value() const {
+    return m_repr == REPR_DOUBLE ? m_double : m_repr == REPR_INT ? m_int : 0;
+}
+
+int Json::int_value() const {
+    return m_repr == REPR_INT ? m_int : m_repr == REPR_DOUBLE ? static_cast<int>(m_double) : 0;
+}
+
+bool Json::bool_value() const {
+    return m_repr == REPR_BOOL && m_bool;
+}
+
+const string & Json::string_value() const {
+    return m_repr == REPR_VALUE ? m_ptr->string_value() : statics().empty_string;
+}
+
+const vector<Json> & Json::array_items() const {
+    return m_repr == REPR_VALUE ? m_ptr->array_items() : statics().empty_vector;
+}
+
+const Json::object & Json::object_items() const {
+    return m_repr == REPR_VALUE ? m_ptr->object_items() : statics().empty_map;
+}
+
+const Json & Json::operator[] (size_t i) const {
+    return m_repr == REPR_VALUE ? (*m_ptr)[i] : static_null();
+}
+
+const Json & Json::operator[] (const string &key) const {
+    return m_repr == REPR_VALUE ? (*m_ptr)[key] : static_null();
+}
+
+const Json & Json::get(const char *key, size_t len) const {
+    if (!is_object())
+        return static_null();
+    const Json::object &items = object_items();
+#ifdef JSON11_FLAT_OBJECT
+    auto iter = items.find(detail::key_view { key, len });
+#else
+    // std::map has no heterogeneous lookup before C++14, so reuse one key buffer per thread,
+    // which stops allocating once it has grown to the longest key looked up.
+    static thread_local string scratch;
+    scratch.assign(key, len);
+    auto iter = items.find(scratch);
+#endif
+    return (iter == items.end()) ? static_null() : iter->second;
+}
 
-double                    JsonValue::number_value()              const { return 0; }
-int                       JsonValue::int_value()                 const { return 0; }
-bool                      JsonValue::bool_value()                const { return false; }
 const string &            JsonValue::string_value()              const { return statics().empty_string; }
 const vector<Json> &      JsonValue::array_items()               const { return statics().empty_vector; }
-const map<string, Json> & JsonValue::object_items()              const { return statics().empty_map; }
+const Json::object &      JsonValue::object_items()              const { return statics().empty_map; }
 const Json &              JsonValue::operator[] (size_t)         const { return static_null(); }
 const Json &              JsonValue::operator[] (const string &) const { return static_null(); }
 
@@ -285,94 +2365,466 @@ const Json & JsonArray::operator[] (size_t i) const {
     if (i >= m_value.size()) return static_null();
     else return m_value[i];
 }
+const Json & JsonLazyObject::operator[] (const string &key) const {
+    auto iter = items().find(key);
+    return (iter == items().end()) ? static_null() : iter->second;
+}
+const Json & JsonLazyArray::operator[] (size_t i) const {
+    if (i >= items().size()) return static_null();
+    else return items()[i];
+}
 
 /* * * * * * * * * * * * * * * * * * * *
  * Comparison
  */
 
+size_t Json::hash() const {
+    switch (type()) {
+    case NUL:    return 0;
+    case BOOL:   return m_bool ? 1 : 2;
+    case NUMBER: {
+        // 0.0 == -0.0, so both must hash the same.
+        const double value = number_value();
+        return value == 0 ? 3 : std::hash<double>()(value);
+    }
+    default:     return m_ptr->hash();
+    }
+}
+
+size_t JsonValue::hash() const {
+    return std::hash<string>()(string_value());
+}
+
 bool Json::operator== (const Json &other) const {
-    if (m_ptr->type() != other.m_ptr->type())
+    const Type t = type();
+    if (t != other.type())
         return false;
 
-    return m_ptr->equals(other.m_ptr.get());
+    switch (t) {
+    case NUL:    return true;
+    case BOOL:   return m_bool == other.m_bool;
+    case NUMBER: return number_value() == other.number_value();
+    default: {
+        if (m_ptr.get() == other.m_ptr.get())
+            return true;
+        const size_t hash = m_ptr->known_hash(), other_hash = other.m_ptr->known_hash();
+        if (hash && other_hash && hash != other_hash)
+            return false;
+        return m_ptr->equals(other.m_ptr.get());
+    }
+    }
 }
 
 bool Json::operator< (const Json &other) const {
-    if (m_ptr->type() != other.m_ptr->type())
-        return m_ptr->type() < other.m_ptr->type();
+    const Type t = type();
+    if (t != other.type())
+        return t < other.type();
 
-    return m_ptr->less(other.m_ptr.get());
+    switch (t) {
+    case NUL:    return false;
+    case BOOL:   return m_bool < other.m_bool;
+    case NUMBER: return number_value() < other.number_value();
+    default:     return m_ptr.get() != other.m_ptr.get() && m_ptr->less(other.m_ptr.get());
+    }
 }
 
 /* * * * * * * * * * * * * * * * * * * *
- * Parsing
+ * Editing
  */
 
-/* esc(c)
- *
- * Format char c suitable for printing in an error message.
- */
-static inline string esc(char c) {
-    char buf[12];
-    if (static_cast<uint8_t>(c) >= 0x20 && static_cast<uint8_t>(c) <= 0x7f) {
-        snprintf(buf, sizeof buf, "'%c' (%d)", c, c);
-    } else {
-        snprintf(buf, sizeof buf, "(%d)", c);
+Json::array & Json::mutable_array() {
+    Json::array *items = unique_array();
+    if (!items) {
+        *this = Json(make_value<JsonArray>(array_items()));
+        items = m_ptr->mutable_array();
     }
-    return string(buf);
+    return *items;
 }
 
-static inline bool in_range(long x, long lower, long upper) {
-    return (x >= lower && x <= upper);
+Json::object & Json::mutable_object() {
+    Json::object *items = unique_object();
+    if (!items) {
+        *this = Json(make_value<JsonObject>(object_items()));
+        items = m_ptr->mutable_object();
+    }
+    return *items;
 }
 
-/* JsonParser
- *
- * Object that tracks all state of an in-progress parse.
- */
-struct JsonParser {
-
-    /* State
-     */
-    const string &str;
-    size_t i;
-    string &err;
-    bool failed;
+Json::array * Json::unique_array() {
+    return m_repr == REPR_VALUE && m_ptr.use_count() == 1 ? m_ptr->mutable_array() : nullptr;
+}
 
-    /* fail(msg, err_ret = Json())
-     *
-     * Mark this parse as failed.
-     */
-    Json fail(string &&msg) {
-        return fail(move(msg), Json());
-    }
+Json::object * Json::unique_object() {
+    return m_repr == REPR_VALUE && m_ptr.use_count() == 1 ? m_ptr->mutable_object() : nullptr;
+}
 
-    template <typename T>
-    T fail(string &&msg, const T err_ret) {
-        if (!failed)
-            err = std::move(msg);
-        failed = true;
-        return err_ret;
-    }
+string * Json::unique_string() {
+    return m_repr == REPR_VALUE && m_ptr.use_count() == 1 ? m_ptr->mutable_string() : nullptr;
+}
 
-    /* consume_whitespace()
-     *
-     * Advance until the current character is non-whitespace.
-     */
-    void consume_whitespace() {
-        while (str[i] == ' ' || str[i] == '\r' || str[i] == '\n' || str[i] == '\t')
-            i++;
-    }
+bool Json::set(const string &key, Json value) {
+    if (is_null())
+        *this = Json(Json::object {});
+    if (!is_object())
+        return false;
+    mutable_object()[key] = move(value);
+    return true;
+}
 
-    /* get_next_token()
-     *
-     * Return the next non-whitespace character. If the end of the input is reached,
-     * flag an error and return 0.
-     */
-    char get_next_token() {
-        consume_whitespace();
-        if (i == str.size())
-            return fail("unexpected end of input", 0);
+bool Json::push_back(Json value) {
+    if (is_null())
+        *this = Json(Json::array {});
+    if (!is_array())
+        return false;
+    mutable_array().push_back(move(value));
+    return true;
+}
+
+bool Json::erase(const string &key) {
+    if (!object_items().count(key))
+        return false;
+    mutable_object().erase(key);
+    return true;
+}
+
+bool Json::erase(size_t index) {
+    if (index >= array_items().size())
+        return false;
+    Json::array &items = mutable_array();
+    items.erase(items.begin() + static_cast<std::ptrdiff_t>(index));
+    return true;
+}
+
+bool Json::set_path(const string &pointer, Json value, string &err) {
+    const Path path = Path::compile(pointer, err);
+    return err.empty() && set_path(path, move(value), err);
+}
+
+bool Json::set_path(const Path &path, Json value, string &err) {
+    Json *node = this;
+    for (size_t k = 0; k < path.m_steps.size(); k++) {
+        const Path::Step &step = path.m_steps[k];
+        const bool last = k + 1 == path.m_steps.size();
+        if (node->is_object()) {
+            if (!last && !node->object_items().count(step.key)) {
+                err = "no member \"" + step.key + "\" in " + path.m_text;
+                return false;
+            }
+            Json::object &items = node->mutable_object();
+            if (last) {
+                items[step.key] = move(value);
+                return true;
+            }
+            node = &items.find(step.key)->second;
+        } else if (node->is_array()) {
+            const size_t size = node->array_items().size();
+            const size_t index = step.index == Path::Step::end_index ? size : step.index;
+            if (step.index == Path::Step::no_index || index > size || (index == size && !last)) {
+                err = "bad array index \"" + step.key + "\" in " + path.m_text;
+                return false;
+            }
+            Json::array &items = node->mutable_array();
+            if (index == size) {
+                items.push_back(move(value));
+                return true;
+            }
+            node = &items[index];
+        } else {
+            err = "cannot index into " + node->dump() + " in " + path.m_text;
+            return false;
+        }
+    }
+    *node = move(value);
+    return true;
+}
+
+/* * * * * * * * * * * * * * * * * * * *
+ * Paths
+ */
+
+/* array_index(token)
+ *
+ * Parse an array reference token: a decimal index without leading zeros, or "-" for the end.
+ */
+static size_t array_index(const string &token) {
+    typedef Json::Path::Step Step;
+    if (token == "-")
+        return Step::end_index;
+    if (token.empty() || token.size() > 18 || (token[0] == '0' && token.size() > 1))
+        return Step::no_index;
+    size_t index = 0;
+    for (char ch : token) {
+        if (ch < '0' || ch > '9')
+            return Step::no_index;
+        index = index * 10 + static_cast<size_t>(ch - '0');
+    }
+    return index;
+}
+
+/* compile_pointer(pointer, steps, err)
+ *
+ * Split a JSON Pointer into its unescaped reference tokens.
+ */
+static bool compile_pointer(const string &pointer, vector<Json::Path::Step> &steps, string &err) {
+    string token;
+    for (size_t i = 1; i <= pointer.size(); i++) {
+        if (i == pointer.size() || pointer[i] == '/') {
+            const size_t index = array_index(token);
+            steps.push_back(Json::Path::Step { move(token), index });
+            token.clear();
+        } else if (pointer[i] == '~') {
+            const char next = i + 1 < pointer.size() ? pointer[i + 1] : 0;
+            if (next != '0' && next != '1') {
+                err = "bad escape in JSON pointer: " + pointer;
+                return false;
+            }
+            token += next == '0' ? '~' : '/';
+            i++;
+        } else {
+            token += pointer[i];
+        }
+    }
+    return true;
+}
+
+/* compile_jsonpath(path, steps, err)
+ *
+ * Split a JSONPath made of .name, [index] and ['name'] (or ["name"]) steps after the $.
+ */
+static bool compile_jsonpath(const string &path, vector<Json::Path::Step> &steps, string &err) {
+    typedef Json::Path::Step Step;
+    size_t i = 1;
+    while (i < path.size()) {
+        if (path[i] == '.') {
+            const size_t end = std::min(path.find('.', i + 1), path.find('[', i + 1));
+            string name = path.substr(i + 1, end == string::npos ? string::npos : end - i - 1);
+            if (name.empty())
+                break;
+            steps.push_back(Step { move(name), Step::no_index });
+            i = end == string::npos ? path.size() : end;
+        } else if (path[i] == '[' && i + 1 < path.size() && (path[i + 1] == '\'' || path[i + 1] == '"')) {
+            const char quote = path[i + 1];
+            string name;
+            for (i += 2; i < path.size() && path[i] != quote; i++) {
+                if (path[i] == '\\' && i + 1 < path.size())
+                    i++;
+                name += path[i];
+            }
+            if (i + 1 >= path.size() || path[i + 1] != ']')
+                break;
+            steps.push_back(Step { move(name), Step::no_index });
+            i += 2;
+        } else if (path[i] == '[') {
+            const size_t end = path.find(']', i);
+            if (end == string::npos)
+                break;
+            string token = path.substr(i + 1, end - i - 1);
+            const size_t index = array_index(token);
+            if (index == Step::no_index || index == Step::end_index)
+                break;
+            steps.push_back(Step { move(token), index });
+            i = end + 1;
+        } else {
+            break;
+        }
+    }
+    if (i != path.size()) {
+        err = "bad JSONPath: " + path;
+        return false;
+    }
+    return true;
+}
+
+Json::Path Json::Path::compile(const string &text, string &err) {
+    Path path;
+    bool ok = true;
+    if (!text.empty() && text[0] == '/')
+        ok = compile_pointer(text, path.m_steps, err);
+    else if (!text.empty() && text[0] == '$')
+        ok = compile_jsonpath(text, path.m_steps, err);
+    else if (!text.empty()) {
+        err = "JSON pointer must start with '/': " + text;
+        ok = false;
+    }
+    if (!ok)
+        return Path();
+    path.m_text = text;
+    return path;
+}
+
+const Json & Json::at(const Path &path) const {
+    const Json *node = this;
+    for (const auto &step : path.m_steps) {
+        if (node->is_object()) {
+            node = &(*node)[step.key];
+        } else if (node->is_array() && step.index < Path::Step::end_index) {
+            node = &(*node)[step.index];
+        } else {
+            return static_null();
+        }
+    }
+    return *node;
+}
+
+/* * * * * * * * * * * * * * * * * * * *
+ * Parsing
+ */
+
+/* esc(c)
+ *
+ * Format char c suitable for printing in an error message.
+ */
+static inline string esc(char c) {
+    char buf[12];
+    if (static_cast<uint8_t>(c) >= 0x20 && static_cast<uint8_t>(c) <= 0x7f) {
+        snprintf(buf, sizeof buf, "'%c' (%d)", c, c);
+    } else {
+        snprintf(buf, sizeof buf, "(%d)", c);
+    }
+    return string(buf);
+}
+
+static inline bool in_range(long x, long lower, long upper) {
+    return (x >= lower && x <= upper);
+}
+
+/* JsonParser
+ *
+ * Object that tracks all state of an in-progress parse.
+ */
+/* Json::Parser::Scratch
+ *
+ * The buffers a Json::Parser keeps between documents: one for decoding escaped strings, and
+ * one per nesting depth for collecting array items. A deque, so that growing it for a deeper
+ * array leaves the vectors of the arrays around it where they are.
+ */
+struct Json::Parser::Scratch {
+    string text;
+    std::deque<vector<Json>> items;
+};
+
+struct JsonParser {
+
+    /* State
+     */
+    const char *str;
+    size_t len;
+    size_t i;
+    string &err;
+    bool failed;
+    JsonAllocator *allocator;
+    bool lazy_strings;
+    vector<LazyDocument::Container> *index = nullptr;
+    string scratch;
+    Json::Parser::Scratch *reuse = nullptr;
+#ifdef JSON11_STATS
+    Json::Stats *stats = nullptr;
+#endif
+
+    JsonParser(const char *str, size_t len, string &err, JsonAllocator *allocator = nullptr,
+               bool lazy_strings = false)
+        : str(str), len(len), i(0), err(err), failed(false),
+          allocator(allocator ? allocator : default_allocator.load(std::memory_order_acquire)),
+          lazy_strings(lazy_strings) {}
+
+    /* fail(msg, err_ret = Json())
+     *
+     * Mark this parse as failed.
+     */
+    Json fail(string &&msg) {
+        return fail(move(msg), Json());
+    }
+
+    template <typename T>
+    T fail(string &&msg, const T err_ret) {
+        if (!failed)
+            err = std::move(msg);
+        failed = true;
+        return err_ret;
+    }
+
+    /* make<T>(args...)
+     *
+     * Construct a T from args, taking its storage from the parse's allocator.
+     */
+    template <typename T, typename... Args>
+    Json make(Args &&... args) {
+#ifdef JSON11_STATS
+        if (stats) {
+            Json value(make_value<T>(allocator, std::forward<Args>(args)...));
+            stats->allocated_bytes += sizeof(T) + payload_bytes(value);
+            return value;
+        }
+#endif
+        return Json(make_value<T>(allocator, std::forward<Args>(args)...));
+    }
+
+#ifdef JSON11_STATS
+    /* payload_bytes(value)
+     *
+     * Estimate the heap storage a new string, array or object holds beyond its node.
+     */
+    static size_t payload_bytes(const Json &value) {
+        switch (value.type()) {
+        case Json::STRING: {
+            const size_t capacity = value.string_value().capacity();
+            return capacity > string().capacity() ? capacity + 1 : 0;
+        }
+        case Json::ARRAY:
+            return value.array_items().capacity() * sizeof(Json);
+        case Json::OBJECT:
+#ifdef JSON11_FLAT_OBJECT
+            return value.object_items().size() * sizeof(Json::object::value_type);
+#else
+            // A std::map node also holds its colour and three links.
+            return value.object_items().size() * (sizeof(Json::object::value_type) + 4 * sizeof(void *));
+#endif
+        default:
+            return 0;
+        }
+    }
+
+    /* count_value(ch, depth)
+     *
+     * Record a value about to be parsed at depth, which starts with ch.
+     */
+    void count_value(char ch, int depth) {
+        const Json::Type type = ch == '"' ? Json::STRING
+                              : ch == '[' ? Json::ARRAY
+                              : ch == '{' ? Json::OBJECT
+                              : ch == 't' || ch == 'f' ? Json::BOOL
+                              : ch == 'n' ? Json::NUL : Json::NUMBER;
+        stats->values[type]++;
+        stats->peak_depth = std::max(stats->peak_depth, depth);
+    }
+#endif
+
+    /* at(j)
+     *
+     * Return the character at position j, or 0 past the end of the input. The input is not
+     * required to be NUL-terminated, so this stands in for std::string's terminator.
+     */
+    char at(size_t j) const {
+        return j < len ? str[j] : 0;
+    }
+
+    /* consume_whitespace()
+     *
+     * Advance until the current character is non-whitespace.
+     */
+    void consume_whitespace() {
+        i = skip_whitespace(str + i, str + len) - str;
+    }
+
+    /* get_next_token()
+     *
+     * Return the next non-whitespace character. If the end of the input is reached,
+     * flag an error and return 0.
+     */
+    char get_next_token() {
+        consume_whitespace();
+        if (i == len)
+            return fail("unexpected end of input", 0);
 
         return str[i++];
     }
@@ -407,53 +2859,100 @@ struct JsonParser {
      * Parse a string, starting at the current position.
      */
     string parse_string() {
+        // Most strings have no escapes. Build those with one exactly-sized allocation: growing
+        // an empty std::string by append can round its capacity up (libstdc++ doubles the
+        // inline capacity), and for the same keys repeated across a million records that slack
+        // adds up to a real share of a document's memory.
+        const char *run_end = scan_string(str + i, str + len);
+        if (run_end != str + len && *run_end == '"') {
+            string out(str + i, run_end);
+            i = run_end - str + 1;
+            return out;
+        }
+
+        if (reuse) {
+            // Decode into the kept buffer, then copy out exactly what the value needs.
+            reuse->text.clear();
+            if (!parse_string(&reuse->text))
+                return "";
+#ifdef JSON11_STATS
+            if (stats)
+                stats->unescaped_bytes += reuse->text.size();
+#endif
+            return reuse->text;
+        }
+
         string out;
+        if (!parse_string(&out))
+            return "";
+#ifdef JSON11_STATS
+        if (stats)
+            stats->unescaped_bytes += out.size();
+#endif
+        return out;
+    }
+
+    /* parse_string(out)
+     *
+     * Parse a string, starting at the current position, and append its value to out. If out
+     * is null the string is only validated. Return false if the parse failed.
+     */
+    bool parse_string(string *out) {
         long last_escaped_codepoint = -1;
         while (true) {
-            if (i == str.size())
-                return fail("unexpected end of input in string", "");
+            // The usual case: a run of non-escaped characters, copied in one go
+            const char *run = str + i;
+            const char *run_end = scan_string(run, str + len);
+            if (run_end != run) {
+                if (out) {
+                    encode_utf8(last_escaped_codepoint, *out);
+                    out->append(run, run_end - run);
+                }
+                last_escaped_codepoint = -1;
+                i = run_end - str;
+            }
+
+            if (i == len)
+                return fail("unexpected end of input in string", false);
 
             char ch = str[i++];
 
             if (ch == '"') {
-                encode_utf8(last_escaped_codepoint, out);
-                return out;
+                if (out)
+                    encode_utf8(last_escaped_codepoint, *out);
+                return true;
             }
 
             if (in_range(ch, 0, 0x1f))
-                return fail("unescaped " + esc(ch) + " in string", "");
-
-            // The usual case: non-escaped characters
-            if (ch != '\\') {
-                encode_utf8(last_escaped_codepoint, out);
-                last_escaped_codepoint = -1;
-                out += ch;
-                continue;
-            }
+                return fail("unescaped " + esc(ch) + " in string", false);
 
             // Handle escapes
-            if (i == str.size())
-                return fail("unexpected end of input in string", "");
+            if (i == len)
+                return fail("unexpected end of input in string", false);
 
             ch = str[i++];
 
             if (ch == 'u') {
-                // Extract 4-byte escape sequence
-                string esc = str.substr(i, 4);
-                // Explicitly check length of the substring. The following loop
-                // relies on std::string returning the terminating NUL when
-                // accessing str[length]. Checking here reduces brittleness.
-                if (esc.length() < 4) {
-                    return fail("bad \\u escape: " + esc, "");
-                }
+                // Extract 4-byte escape sequence. Explicitly check the remaining length, since
+                // the input is not guaranteed to be terminated.
+                if (len - i < 4)
+                    return fail("bad \\u escape: " + string(str + i, len - i), false);
+
+                long codepoint = 0;
                 for (int j = 0; j < 4; j++) {
-                    if (!in_range(esc[j], 'a', 'f') && !in_range(esc[j], 'A', 'F')
-                            && !in_range(esc[j], '0', '9'))
-                        return fail("bad \\u escape: " + esc, "");
+                    const char digit = str[i + j];
+                    long value;
+                    if (in_range(digit, 'a', 'f'))
+                        value = digit - 'a' + 10;
+                    else if (in_range(digit, 'A', 'F'))
+                        value = digit - 'A' + 10;
+                    else if (in_range(digit, '0', '9'))
+                        value = digit - '0';
+                    else
+                        return fail("bad \\u escape: " + string(str + i, 4), false);
+                    codepoint = (codepoint << 4) | value;
                 }
 
-                long codepoint = strtol(esc.data(), nullptr, 16);
-
                 // JSON specifies that characters outside the BMP shall be encoded as a pair
                 // of 4-hex-digit \u escapes encoding their surrogate pair components. Check
                 // whether we're in the middle of such a beast: the previous codepoint was an
@@ -462,11 +2961,13 @@ struct JsonParser {
                         && in_range(codepoint, 0xDC00, 0xDFFF)) {
                     // Reassemble the two surrogate pairs into one astral-plane character, per
                     // the UTF-16 algorithm.
-                    encode_utf8((((last_escaped_codepoint - 0xD800) << 10)
-                                 | (codepoint - 0xDC00)) + 0x10000, out);
+                    if (out)
+                        encode_utf8((((last_escaped_codepoint - 0xD800) << 10)
+                                     | (codepoint - 0xDC00)) + 0x10000, *out);
                     last_escaped_codepoint = -1;
                 } else {
-                    encode_utf8(last_escaped_codepoint, out);
+                    if (out)
+                        encode_utf8(last_escaped_codepoint, *out);
                     last_escaped_codepoint = codepoint;
                 }
 
@@ -474,27 +2975,49 @@ struct JsonParser {
                 continue;
             }
 
-            encode_utf8(last_escaped_codepoint, out);
+            if (out)
+                encode_utf8(last_escaped_codepoint, *out);
             last_escaped_codepoint = -1;
 
+            char decoded;
             if (ch == 'b') {
-                out += '\b';
+                decoded = '\b';
             } else if (ch == 'f') {
-                out += '\f';
+                decoded = '\f';
             } else if (ch == 'n') {
-                out += '\n';
+                decoded = '\n';
             } else if (ch == 'r') {
-                out += '\r';
+                decoded = '\r';
             } else if (ch == 't') {
-                out += '\t';
+                decoded = '\t';
             } else if (ch == '"' || ch == '\\' || ch == '/') {
-                out += ch;
+                decoded = ch;
             } else {
-                return fail("invalid escape character " + esc(ch), "");
+                return fail("invalid escape character " + esc(ch), false);
             }
+            if (out)
+                *out += decoded;
         }
     }
 
+    /* parse_string_value()
+     *
+     * Parse a string value, starting at the current position. In lazy mode the result only
+     * refers to the input; otherwise it owns a decoded copy.
+     */
+    Json parse_string_value() {
+        if (!lazy_strings)
+            return make<JsonString>(parse_string());
+
+        const size_t start = i;
+        if (!parse_string(nullptr))
+            return Json();
+
+        const size_t length = i - 1 - start;
+        const bool escaped = std::memchr(str + start, '\\', length) != nullptr;
+        return make<JsonStringView>(str + start, length, escaped);
+    }
+
     /* parse_number()
      *
      * Parse a double.
@@ -502,52 +3025,88 @@ struct JsonParser {
     Json parse_number() {
         size_t start_pos = i;
 
-        if (str[i] == '-')
+        bool negative = false;
+        if (at(i) == '-') {
+            negative = true;
             i++;
+        }
+
+        // The first 19 significant digits are accumulated into mantissa as they are
+        // validated, so the value is mantissa * 10^exponent unless digits were truncated.
+        uint64_t mantissa = 0;
+        int digits = 0;
+        long exponent = 0;
+        bool truncated = false;
 
         // Integer part
-        if (str[i] == '0') {
+        if (at(i) == '0') {
             i++;
-            if (in_range(str[i], '0', '9'))
+            if (in_range(at(i), '0', '9'))
                 return fail("leading 0s not permitted in numbers");
-        } else if (in_range(str[i], '1', '9')) {
-            i++;
-            while (in_range(str[i], '0', '9'))
-                i++;
+        } else if (in_range(at(i), '1', '9')) {
+            while (in_range(at(i), '0', '9')) {
+                const int digit = str[i++] - '0';
+                if (digits < 19) {
+                    mantissa = mantissa * 10 + digit;
+                    digits++;
+                } else {
+                    exponent++;
+                    truncated |= digit != 0;
+                }
+            }
         } else {
-            return fail("invalid " + esc(str[i]) + " in number");
+            return fail("invalid " + esc(at(i)) + " in number");
         }
 
-        if (str[i] != '.' && str[i] != 'e' && str[i] != 'E'
+        if (at(i) != '.' && at(i) != 'e' && at(i) != 'E'
                 && (i - start_pos) <= static_cast<size_t>(std::numeric_limits<int>::digits10)) {
-            return std::atoi(str.c_str() + start_pos);
+            const int value = static_cast<int>(mantissa);
+            return Json(negative ? -value : value);
         }
 
         // Decimal part
-        if (str[i] == '.') {
+        if (at(i) == '.') {
             i++;
-            if (!in_range(str[i], '0', '9'))
+            if (!in_range(at(i), '0', '9'))
                 return fail("at least one digit required in fractional part");
 
-            while (in_range(str[i], '0', '9'))
-                i++;
+            while (in_range(at(i), '0', '9')) {
+                const int digit = str[i++] - '0';
+                if (digits < 19) {
+                    mantissa = mantissa * 10 + digit;
+                    exponent--;
+                    // Leading zeros are not significant.
+                    if (mantissa != 0)
+                        digits++;
+                } else {
+                    truncated |= digit != 0;
+                }
+            }
         }
 
         // Exponent part
-        if (str[i] == 'e' || str[i] == 'E') {
+        if (at(i) == 'e' || at(i) == 'E') {
             i++;
 
-            if (str[i] == '+' || str[i] == '-')
-                i++;
+            bool negative_exponent = false;
+            if (at(i) == '+' || at(i) == '-')
+                negative_exponent = str[i++] == '-';
 
-            if (!in_range(str[i], '0', '9'))
+            if (!in_range(at(i), '0', '9'))
                 return fail("at least one digit required in exponent");
 
-            while (in_range(str[i], '0', '9'))
+            // Saturate; anything this large over- or underflows regardless.
+            long explicit_exponent = 0;
+            while (in_range(at(i), '0', '9')) {
+                if (explicit_exponent < 100000)
+                    explicit_exponent = explicit_exponent * 10 + (str[i] - '0');
                 i++;
+            }
+            exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
         }
 
-        return std::strtod(str.c_str() + start_pos, nullptr);
+        return Json(decimal_to_double(negative, mantissa, exponent, truncated,
+                                      str + start_pos, i - start_pos));
     }
 
     /* expect(str, res)
@@ -558,11 +3117,13 @@ struct JsonParser {
     Json expect(const string &expected, Json res) {
         assert(i != 0);
         i--;
-        if (str.compare(i, expected.length(), expected) == 0) {
+        if (len - i >= expected.length()
+                && std::memcmp(str + i, expected.data(), expected.length()) == 0) {
             i += expected.length();
             return res;
         } else {
-            return fail("parse error: expected " + expected + ", got " + str.substr(i, expected.length()));
+            return fail("parse error: expected " + expected + ", got "
+                        + string(str + i, std::min(expected.length(), len - i)));
         }
     }
 
@@ -578,6 +3139,10 @@ struct JsonParser {
         char ch = get_next_token();
         if (failed)
             return Json();
+#ifdef JSON11_STATS
+        if (stats)
+            count_value(ch, depth);
+#endif
 
         if (ch == '-' || (ch >= '0' && ch <= '9')) {
             i--;
@@ -594,13 +3159,13 @@ struct JsonParser {
             return expect("null", Json());
 
         if (ch == '"')
-            return parse_string();
+            return parse_string_value();
 
         if (ch == '{') {
-            map<string, Json> data;
+            Json::object data;
             ch = get_next_token();
             if (ch == '}')
-                return data;
+                return make<JsonObject>(move(data));
 
             while (1) {
                 if (ch != '"')
@@ -626,14 +3191,17 @@ struct JsonParser {
 
                 ch = get_next_token();
             }
-            return data;
+            return make<JsonObject>(move(data));
         }
 
         if (ch == '[') {
+            if (reuse)
+                return parse_array_reusing(depth);
+
             vector<Json> data;
             ch = get_next_token();
             if (ch == ']')
-                return data;
+                return make<JsonArray>(move(data));
 
             while (1) {
                 i--;
@@ -650,36 +3218,1277 @@ struct JsonParser {
                 ch = get_next_token();
                 (void)ch;
             }
-            return data;
+            return make<JsonArray>(move(data));
         }
 
         return fail("expected value, got " + esc(ch));
     }
-};
 
-Json Json::parse(const string &in, string &err) {
-    JsonParser parser { in, 0, err, false };
-    Json result = parser.parse_json(0);
+    /* parse_array_reusing(depth)
+     *
+     * The rest of parse_json() for an array, collecting the items in reuse's vector for depth
+     * so that the array is built with one exactly-sized allocation.
+     */
+    Json parse_array_reusing(int depth) {
+        if (reuse->items.size() <= static_cast<size_t>(depth))
+            reuse->items.resize(depth + 1);
+        vector<Json> &data = reuse->items[depth];
+        data.clear();
 
-    // Check for any trailing garbage
-    parser.consume_whitespace();
-    if (parser.i != in.size())
-        return parser.fail("unexpected trailing " + esc(in[parser.i]));
+        char ch = get_next_token();
+        if (ch != ']') {
+            // As in parse_json(), the token after a ',' goes back through parse_json().
+            while (true) {
+                i--;
+                data.push_back(parse_json(depth + 1));
+                if (failed)
+                    return Json();
 
-    return result;
-}
+                ch = get_next_token();
+                if (ch == ']')
+                    break;
+                if (ch != ',')
+                    return fail("expected ',' in list, got " + esc(ch));
 
-// Documented in json11.hpp
-vector<Json> Json::parse_multi(const string &in, string &err) {
-    JsonParser parser { in, 0, err, false };
+                ch = get_next_token();
+            }
+        }
+        Json result = make<JsonArray>(vector<Json>(std::make_move_iterator(data.begin()),
+                                                   std::make_move_iterator(data.end())));
+        data.clear();
+        return result;
+    }
 
-    vector<Json> json_vec;
-    while (parser.i != in.size() && !parser.failed) {
-        json_vec.push_back(parser.parse_json(0));
-        // Check for another object
-        parser.consume_whitespace();
+    /* skip_json(depth)
+     *
+     * Validate a JSON value like parse_json() and move past it, without building or decoding
+     * anything. If index is set, record the extent of every array and object in it. Return
+     * false if the parse failed.
+     */
+    bool skip_json(int depth) {
+        if (depth > max_depth)
+            return fail("exceeded maximum nesting depth", false);
+
+        char ch = get_next_token();
+        if (failed)
+            return false;
+
+        if (ch == '-' || (ch >= '0' && ch <= '9')) {
+            i--;
+            parse_number();
+            return !failed;
+        }
+
+        if (ch == 't' || ch == 'f' || ch == 'n') {
+            expect(ch == 't' ? "true" : ch == 'f' ? "false" : "null", Json());
+            return !failed;
+        }
+
+        if (ch == '"')
+            return parse_string(nullptr);
+
+        if (ch == '{' || ch == '[') {
+            const bool object = ch == '{';
+            const char close = object ? '}' : ']';
+            const size_t container = index ? index->size() : 0;
+            if (index)
+                index->push_back(LazyDocument::Container { 0, 0 });
+
+            ch = get_next_token();
+            if (ch != close) {
+                // After a ',' the loop goes round again, where a closing bracket is an error.
+                while (true) {
+                    if (object) {
+                        if (ch != '"')
+                            return fail("expected '\"' in object, got " + esc(ch), false);
+                        if (!parse_string(nullptr))
+                            return false;
+                        ch = get_next_token();
+                        if (ch != ':')
+                            return fail("expected ':' in object, got " + esc(ch), false);
+                    } else {
+                        i--;
+                    }
+
+                    if (!skip_json(depth + 1))
+                        return false;
+
+                    ch = get_next_token();
+                    if (ch == close)
+                        break;
+                    if (ch != ',')
+                        return fail(string("expected ',' in ") + (object ? "object" : "list") + ", got "
+                                    + esc(ch), false);
+
+                    ch = get_next_token();
+                }
+            }
+
+            if (index)
+                (*index)[container] = LazyDocument::Container { i, index->size() };
+            return true;
+        }
+
+        return fail("expected value, got " + esc(ch), false);
     }
-    return json_vec;
+
+    /* parse_lazy_json(doc, container)
+     *
+     * Parse the value at the current position of a validated Json::parse_lazy document. An
+     * array or object becomes a lazy node, and is skipped using the index; container is the
+     * index of the next container in the input, and is advanced past it.
+     */
+    Json parse_lazy_json(const std::shared_ptr<const LazyDocument> &doc, size_t &container) {
+        consume_whitespace();
+        const char ch = str[i];
+        if (ch != '{' && ch != '[')
+            return parse_json(0);
+
+        const size_t start = i;
+        const size_t k = container;
+        i = doc->containers[k].end;
+        container = doc->containers[k].next;
+        if (ch == '{')
+            return make<JsonLazyObject>(doc, start, k);
+        return make<JsonLazyArray>(doc, start, k);
+    }
+
+    /* extract_json(path, step, depth)
+     *
+     * Parse the current value and return the part of it that path.m_steps[step...] leads to,
+     * or Json() if there is none. Everything else is only validated, as by skip_json(). The
+     * whole value is read, so that of duplicate keys the last wins, as in parse_json().
+     */
+    Json extract_json(const Json::Path &path, size_t step, int depth) {
+        if (step == path.m_steps.size())
+            return parse_json(depth);
+        if (depth > max_depth)
+            return fail("exceeded maximum nesting depth");
+
+        const Json::Path::Step &want = path.m_steps[step];
+        char ch = get_next_token();
+        if (failed)
+            return Json();
+
+        if (ch == '{') {
+            Json found;
+            ch = get_next_token();
+            while (ch != '}') {
+                if (ch != '"')
+                    return fail("expected '\"' in object, got " + esc(ch));
+                scratch.clear();
+                if (!parse_string(&scratch))
+                    return Json();
+                ch = get_next_token();
+                if (ch != ':')
+                    return fail("expected ':' in object, got " + esc(ch));
+                if (scratch == want.key)
+                    found = extract_json(path, step + 1, depth + 1);
+                else
+                    skip_json(depth + 1);
+                if (failed)
+                    return Json();
+
+                ch = get_next_token();
+                if (ch == '}')
+                    break;
+                if (ch != ',')
+                    return fail("expected ',' in object, got " + esc(ch));
+                ch = get_next_token();
+                if (ch == '}')
+                    return fail("expected '\"' in object, got " + esc(ch));
+            }
+            return found;
+        }
+
+        if (ch == '[') {
+            Json found;
+            ch = get_next_token();
+            for (size_t n = 0; ch != ']'; n++) {
+                i--;
+                if (n == want.index)
+                    found = extract_json(path, step + 1, depth + 1);
+                else
+                    skip_json(depth + 1);
+                if (failed)
+                    return Json();
+
+                ch = get_next_token();
+                if (ch == ']')
+                    break;
+                if (ch != ',')
+                    return fail("expected ',' in list, got " + esc(ch));
+                ch = get_next_token();
+                if (ch == ']')
+                    return fail("expected value, got " + esc(ch));
+            }
+            return found;
+        }
+
+        // A scalar has nothing inside it, but must still be valid.
+        i--;
+        skip_json(depth);
+        return Json();
+    }
+
+    /* parse_events(handler, depth, buf)
+     *
+     * Parse a JSON value like parse_json(), but report it to handler instead of building it.
+     * buf is scratch space for strings and keys. Return false if the parse failed or the
+     * handler asked to stop.
+     */
+    bool parse_events(JsonHandler &handler, int depth, string &buf) {
+        if (depth > max_depth) {
+            return fail("exceeded maximum nesting depth", false);
+        }
+
+        char ch = get_next_token();
+        if (failed)
+            return false;
+
+        if (ch == '-' || (ch >= '0' && ch <= '9')) {
+            i--;
+            const Json number = parse_number();
+            if (failed)
+                return false;
+            return number.m_repr == Json::REPR_INT ? handler.on_int(number.m_int)
+                                                   : handler.on_number(number.m_double);
+        }
+
+        if (ch == 't') {
+            expect("true", Json());
+            return !failed && handler.on_bool(true);
+        }
+
+        if (ch == 'f') {
+            expect("false", Json());
+            return !failed && handler.on_bool(false);
+        }
+
+        if (ch == 'n') {
+            expect("null", Json());
+            return !failed && handler.on_null();
+        }
+
+        if (ch == '"') {
+            buf.clear();
+            return parse_string(&buf) && handler.on_string(buf);
+        }
+
+        if (ch == '{') {
+            if (!handler.on_start_object())
+                return false;
+
+            ch = get_next_token();
+            if (ch == '}')
+                return handler.on_end_object();
+
+            while (1) {
+                if (ch != '"')
+                    return fail("expected '\"' in object, got " + esc(ch), false);
+
+                buf.clear();
+                if (!parse_string(&buf) || !handler.on_key(buf))
+                    return false;
+
+                ch = get_next_token();
+                if (ch != ':')
+                    return fail("expected ':' in object, got " + esc(ch), false);
+
+                if (!parse_events(handler, depth + 1, buf))
+                    return false;
+
+                ch = get_next_token();
+                if (ch == '}')
+                    break;
+                if (ch != ',')
+                    return fail("expected ',' in object, got " + esc(ch), false);
+
+                ch = get_next_token();
+            }
+            return handler.on_end_object();
+        }
+
+        if (ch == '[') {
+            if (!handler.on_start_array())
+                return false;
+
+            ch = get_next_token();
+            if (ch == ']')
+                return handler.on_end_array();
+
+            while (1) {
+                i--;
+                if (!parse_events(handler, depth + 1, buf))
+                    return false;
+
+                ch = get_next_token();
+                if (ch == ']')
+                    break;
+                if (ch != ',')
+                    return fail("expected ',' in list, got " + esc(ch), false);
+
+                ch = get_next_token();
+                (void)ch;
+            }
+            return handler.on_end_array();
+        }
+
+        return fail("expected value, got " + esc(ch), false);
+    }
+};
+
+/* parse_document(in, len, err, allocator, lazy_strings)
+ *
+ * Parse a single JSON value spanning the whole of in.
+ */
+static Json parse_document(const char *in, size_t len, string &err, JsonAllocator *allocator,
+                           bool lazy_strings) {
+    JsonParser parser(in, len, err, allocator, lazy_strings);
+    Json result = parser.parse_json(0);
+
+    // Check for any trailing garbage
+    parser.consume_whitespace();
+    if (parser.i != len)
+        return parser.fail("unexpected trailing " + esc(in[parser.i]));
+
+    return result;
+}
+
+Json Json::parse(const string &in, string &err) {
+    return parse_document(in.data(), in.size(), err, nullptr, false);
+}
+
+Json Json::parse(const char *in, size_t len, string &err) {
+    return parse_document(in, len, err, nullptr, false);
+}
+
+#ifdef JSON11_STATS
+Json Json::parse(const string &in, string &err, Stats &stats) {
+    const auto start = std::chrono::steady_clock::now();
+    JsonParser parser(in.data(), in.size(), err);
+    parser.stats = &stats;
+    Json result = parser.parse_json(0);
+    parser.consume_whitespace();
+    if (parser.i != in.size())
+        result = parser.fail("unexpected trailing " + esc(in[parser.i]));
+    stats.parse_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+#endif
+
+Json::Parser::Parser(JsonAllocator *allocator)
+    : m_scratch(new Scratch), m_allocator(allocator) {}
+Json::Parser::Parser(Parser &&) noexcept = default;
+Json::Parser & Json::Parser::operator=(Parser &&) noexcept = default;
+Json::Parser::~Parser() {}
+
+Json Json::Parser::parse(const string &in, string &err) {
+    return parse(in.data(), in.size(), err);
+}
+
+Json Json::Parser::parse(const char *in, size_t len, string &err) {
+    JsonParser parser(in, len, err, m_allocator);
+    parser.reuse = m_scratch.get();
+    Json result = parser.parse_json(0);
+    parser.consume_whitespace();
+    if (!parser.failed && parser.i != len)
+        parser.fail("unexpected trailing " + esc(in[parser.i]));
+    if (parser.failed) {
+        // Don't hold on to the values of a document that was abandoned halfway.
+        for (auto &items : m_scratch->items)
+            items.clear();
+        return Json();
+    }
+    return result;
+}
+
+size_t Json::Parser::parse(const string *inputs, size_t count, Json *out, string *errors) {
+    size_t failures = 0;
+    string err;
+    for (size_t k = 0; k < count; k++) {
+        err.clear();
+        out[k] = parse(inputs[k], err);
+        failures += !err.empty();
+        if (errors)
+            errors[k] = err;
+    }
+    return failures;
+}
+
+Json Json::parse(const string &in, string &err, JsonAllocator &allocator) {
+    return parse_document(in.data(), in.size(), err, &allocator, false);
+}
+
+Json Json::parse_view(const char *in, size_t len, string &err) {
+    return parse_document(in, len, err, nullptr, true);
+}
+
+bool Json::parse(const char *in, size_t len, JsonHandler &handler, string &err) {
+    JsonParser parser(in, len, err);
+    string buf;
+    if (!parser.parse_events(handler, 0, buf))
+        return false;
+
+    // Check for any trailing garbage
+    parser.consume_whitespace();
+    if (parser.i != len)
+        return parser.fail("unexpected trailing " + esc(in[parser.i]), false);
+
+    return true;
+}
+
+/* parse_multi_into(in, len, err, out)
+ *
+ * Parse the values in [in, in + len) as parse_multi does, appending them to out.
+ */
+static void parse_multi_into(const char *in, size_t len, string &err, vector<Json> &out) {
+    JsonParser parser(in, len, err);
+    while (parser.i != len && !parser.failed) {
+        out.push_back(parser.parse_json(0));
+        // Check for another object
+        parser.consume_whitespace();
+    }
+}
+
+// Documented in json11.hpp
+vector<Json> Json::parse_multi(const string &in, string &err) {
+    vector<Json> json_vec;
+    parse_multi_into(in.data(), in.size(), err, json_vec);
+    return json_vec;
+}
+
+/* parse_ndjson_pieces(in, err, pieces, run)
+ *
+ * Split in into about the given number of pieces at line boundaries, parse each piece in a
+ * task passed to run, wait for them all, and stitch the results together in input order.
+ */
+static vector<Json> parse_ndjson_pieces(const string &in, string &err, size_t pieces,
+                                        const Json::executor &run) {
+    // Pieces much smaller than this cost more to hand out than to parse.
+    const size_t min_piece_size = 64 * 1024;
+    pieces = std::max<size_t>(1, std::min(pieces, in.size() / min_piece_size));
+
+    vector<size_t> bounds { 0 };
+    for (size_t k = 1; k < pieces; k++) {
+        const size_t target = std::max(bounds.back(), in.size() / pieces * k);
+        const size_t newline = in.find('\n', target);
+        if (newline == string::npos)
+            break;
+        if (newline + 1 > bounds.back())
+            bounds.push_back(newline + 1);
+    }
+    bounds.push_back(in.size());
+    pieces = bounds.size() - 1;
+
+    vector<vector<Json>> results(pieces);
+    vector<string> errors(pieces);
+    std::mutex mutex;
+    std::condition_variable done;
+    size_t remaining = pieces;
+
+    for (size_t k = 0; k < pieces; k++) {
+        run([&, k] {
+            const char *begin = in.data() + bounds[k];
+            const char *end = in.data() + bounds[k + 1];
+            // Only the first piece may start with whitespace that parse_multi would reject.
+            if (k > 0)
+                begin = skip_whitespace(begin, end);
+            parse_multi_into(begin, end - begin, errors[k], results[k]);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--remaining == 0)
+                done.notify_one();
+        });
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&] { return remaining == 0; });
+    }
+
+    // Everything up to and including the first piece that failed, as a serial parse would.
+    vector<Json> json_vec;
+    for (size_t k = 0; k < pieces; k++) {
+        json_vec.insert(json_vec.end(), std::make_move_iterator(results[k].begin()),
+                        std::make_move_iterator(results[k].end()));
+        if (!errors[k].empty()) {
+            err = move(errors[k]);
+            break;
+        }
+    }
+    return json_vec;
+}
+
+vector<Json> Json::parse_ndjson(const string &in, string &err, const executor &run, size_t pieces) {
+    return parse_ndjson_pieces(in, err, pieces, run);
+}
+
+vector<Json> Json::parse_ndjson(const string &in, string &err, unsigned threads) {
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    vector<std::thread> workers;
+    vector<Json> json_vec = parse_ndjson_pieces(in, err, threads, [&](std::function<void()> task) {
+        workers.emplace_back(move(task));
+    });
+    for (auto &worker : workers)
+        worker.join();
+    return json_vec;
+}
+
+/* dump_item(item, out)
+ *
+ * Serialize one item of an array or object the way dump(values, out) does, less the ", ".
+ */
+static void dump_item(const Json &item, JsonWriter &out) {
+    out.write(item);
+}
+
+static void dump_item(const Json::object::value_type &item, JsonWriter &out) {
+    dump(item.first, out);
+    out += ": ";
+    out.write(item.second);
+}
+
+/* dump_pieces(items, open, close, out, pieces, run)
+ *
+ * Serialize items between open and close in up to `pieces` concurrent tasks, each filling a
+ * buffer of its own with the text of a run of consecutive items, and then join the buffers.
+ */
+template <typename T>
+static void dump_pieces(const T &items, const char *open, const char *close, string &out,
+                        size_t pieces, const Json::executor &run) {
+    // Pieces with fewer items than this cost more to hand out than to dump.
+    const size_t min_piece_items = 1024;
+    pieces = std::max<size_t>(1, std::min(pieces, items.size() / min_piece_items));
+
+    vector<typename T::const_iterator> bounds { items.begin() };
+    for (size_t k = 1; k < pieces; k++) {
+        auto it = bounds.back();
+        std::advance(it, items.size() / pieces);
+        bounds.push_back(it);
+    }
+    bounds.push_back(items.end());
+
+    vector<string> buffers(pieces);
+    std::mutex mutex;
+    std::condition_variable done;
+    size_t remaining = pieces;
+
+    for (size_t k = 0; k < pieces; k++) {
+        run([&, k] {
+            {
+                JsonWriter writer(buffers[k]);
+                for (auto it = bounds[k]; it != bounds[k + 1]; ++it) {
+                    if (k > 0 || it != bounds[k])
+                        writer += ", ";
+                    dump_item(*it, writer);
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--remaining == 0)
+                done.notify_one();
+        });
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&] { return remaining == 0; });
+    }
+
+    size_t size = out.size() + 2;
+    for (const string &buffer : buffers)
+        size += buffer.size();
+    out.reserve(size);
+    out += open;
+    for (const string &buffer : buffers)
+        out += buffer;
+    out += close;
+}
+
+void Json::dump_parallel(string &out, const executor &run, size_t pieces) const {
+    // A fragment already holds its text.
+    if (m_repr == REPR_VALUE && !dynamic_cast<const JsonFragment *>(m_ptr.get())) {
+        if (is_array())
+            return dump_pieces(array_items(), "[", "]", out, pieces, run);
+        if (is_object())
+            return dump_pieces(object_items(), "{", "}", out, pieces, run);
+    }
+    dump(out);
+}
+
+void Json::dump_parallel(string &out, unsigned threads) const {
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    vector<std::thread> workers;
+    dump_parallel(out, [&](std::function<void()> task) {
+        workers.emplace_back(move(task));
+    }, threads);
+    for (auto &worker : workers)
+        worker.join();
+}
+
+const string & JsonStringView::string_value() const {
+    std::call_once(m_once, [this] {
+        if (!m_escaped) {
+            m_value.assign(m_data, m_length);
+            return;
+        }
+
+        // The text was validated when it was parsed, and is followed by its closing quote.
+        string err;
+        JsonParser parser(m_data, m_length + 1, err);
+        m_value.reserve(m_length);
+        parser.parse_string(&m_value);
+    });
+    return m_value;
+}
+
+template <>
+void LazyContainer<Json::ARRAY, Json::array>::materialize() const {
+    // The document was validated when it was parsed.
+    string err;
+    JsonParser parser(m_doc->str, m_doc->len, err, nullptr, true);
+    parser.i = m_start + 1;
+    size_t container = m_container + 1;
+    char ch = parser.get_next_token();
+    while (ch != ']') {
+        parser.i--;
+        m_items.push_back(parser.parse_lazy_json(m_doc, container));
+        ch = parser.get_next_token();
+        if (ch == ',')
+            ch = parser.get_next_token();
+    }
+}
+
+template <>
+void LazyContainer<Json::OBJECT, Json::object>::materialize() const {
+    string err;
+    JsonParser parser(m_doc->str, m_doc->len, err, nullptr, true);
+    parser.i = m_start + 1;
+    size_t container = m_container + 1;
+    char ch = parser.get_next_token();
+    while (ch != '}') {
+        string key = parser.parse_string();
+        parser.get_next_token();
+        m_items[std::move(key)] = parser.parse_lazy_json(m_doc, container);
+        ch = parser.get_next_token();
+        if (ch == ',')
+            ch = parser.get_next_token();
+    }
+}
+
+Json Json::extract(const string &in, const Path &path, string &err) {
+    JsonParser parser(in.data(), in.size(), err);
+    Json result = parser.extract_json(path, 0, 0);
+
+    // Check for any trailing garbage, as parse() does
+    parser.consume_whitespace();
+    if (!parser.failed && parser.i != in.size())
+        return parser.fail("unexpected trailing " + esc(in[parser.i]));
+    return parser.failed ? Json() : result;
+}
+
+Json Json::parse_lazy(const char *in, size_t len, string &err) {
+    std::shared_ptr<LazyDocument> doc = make_shared<LazyDocument>();
+    doc->str = in;
+    doc->len = len;
+
+    // Stage one: validate the whole input and index its containers.
+    JsonParser parser(in, len, err, nullptr, true);
+    parser.index = &doc->containers;
+    parser.skip_json(0);
+    if (parser.failed)
+        return Json();
+    parser.consume_whitespace();
+    if (parser.i != len)
+        return parser.fail("unexpected trailing " + esc(in[parser.i]));
+
+    // Stage two, for the top level only: the rest happens as the result is read.
+    parser.index = nullptr;
+    parser.i = 0;
+    size_t container = 0;
+    return parser.parse_lazy_json(doc, container);
+}
+
+/* * * * * * * * * * * * * * * * * * * *
+ * Reading
+ */
+
+JsonReader::JsonReader(const char *in, size_t len, string &err)
+    : m_parser(new JsonParser(in, len, err)), m_depth(0), m_first(false) {}
+
+JsonReader::~JsonReader() {}
+
+bool JsonReader::failed() const {
+    return m_parser->failed;
+}
+
+bool JsonReader::read_null() {
+    JsonParser &parser = *m_parser;
+    parser.consume_whitespace();
+    if (parser.failed || parser.at(parser.i) != 'n')
+        return false;
+    parser.i++;
+    parser.expect("null", Json());
+    return !parser.failed;
+}
+
+bool JsonReader::read(double &out) {
+    if (read_null())
+        return true;
+    JsonParser &parser = *m_parser;
+    const char ch = parser.get_next_token();
+    if (parser.failed)
+        return false;
+    if (ch != '-' && (ch < '0' || ch > '9'))
+        return parser.fail("expected number, got " + esc(ch), false);
+    parser.i--;
+    const Json number = parser.parse_number();
+    if (parser.failed)
+        return false;
+    out = number.number_value();
+    return true;
+}
+
+bool JsonReader::read(bool &out) {
+    if (read_null())
+        return true;
+    JsonParser &parser = *m_parser;
+    const char ch = parser.get_next_token();
+    if (parser.failed)
+        return false;
+    if (ch != 't' && ch != 'f')
+        return parser.fail("expected boolean, got " + esc(ch), false);
+    out = ch == 't';
+    parser.expect(out ? "true" : "false", Json());
+    return !parser.failed;
+}
+
+bool JsonReader::read(string &out) {
+    if (read_null())
+        return true;
+    JsonParser &parser = *m_parser;
+    const char ch = parser.get_next_token();
+    if (parser.failed)
+        return false;
+    if (ch != '"')
+        return parser.fail("expected string, got " + esc(ch), false);
+    out.clear();
+    return parser.parse_string(&out);
+}
+
+bool JsonReader::read(Json &out) {
+    if (m_parser->failed)
+        return false;
+    out = m_parser->parse_json(m_depth);
+    return !m_parser->failed;
+}
+
+bool JsonReader::start_object() {
+    JsonParser &parser = *m_parser;
+    if (parser.failed)
+        return false;
+    const char ch = parser.get_next_token();
+    if (parser.failed)
+        return false;
+    if (ch != '{')
+        return parser.fail("expected '{', got " + esc(ch), false);
+    if (++m_depth > max_depth)
+        return parser.fail("exceeded maximum nesting depth", false);
+    m_first = true;
+    return true;
+}
+
+bool JsonReader::start_array() {
+    JsonParser &parser = *m_parser;
+    if (parser.failed)
+        return false;
+    const char ch = parser.get_next_token();
+    if (parser.failed)
+        return false;
+    if (ch != '[')
+        return parser.fail("expected '[', got " + esc(ch), false);
+    if (++m_depth > max_depth)
+        return parser.fail("exceeded maximum nesting depth", false);
+    m_first = true;
+    return true;
+}
+
+bool JsonReader::next_key(string &key) {
+    JsonParser &parser = *m_parser;
+    if (parser.failed)
+        return false;
+    char ch = parser.get_next_token();
+    if (ch == '}') {
+        m_depth--;
+        m_first = false;
+        return false;
+    }
+    if (!m_first) {
+        if (ch != ',')
+            return parser.fail("expected ',' in object, got " + esc(ch), false);
+        ch = parser.get_next_token();
+    }
+    m_first = false;
+    if (parser.failed)
+        return false;
+    if (ch != '"')
+        return parser.fail("expected '\"' in object, got " + esc(ch), false);
+    key.clear();
+    if (!parser.parse_string(&key))
+        return false;
+    ch = parser.get_next_token();
+    if (ch != ':')
+        return parser.fail("expected ':' in object, got " + esc(ch), false);
+    return true;
+}
+
+bool JsonReader::next_item() {
+    JsonParser &parser = *m_parser;
+    if (parser.failed)
+        return false;
+    if (m_first) {
+        m_first = false;
+        parser.consume_whitespace();
+        if (parser.at(parser.i) != ']')
+            return true;
+        parser.i++;
+        m_depth--;
+        return false;
+    }
+    const char ch = parser.get_next_token();
+    if (ch == ']') {
+        m_depth--;
+        return false;
+    }
+    if (ch != ',')
+        return parser.fail("expected ',' in list, got " + esc(ch), false);
+    return true;
+}
+
+bool JsonReader::skip() {
+    return !m_parser->failed && m_parser->skip_json(m_depth);
+}
+
+bool JsonReader::finish() {
+    JsonParser &parser = *m_parser;
+    if (parser.failed)
+        return false;
+    parser.consume_whitespace();
+    if (parser.i != parser.len)
+        return parser.fail("unexpected trailing " + esc(parser.str[parser.i]), false);
+    return true;
+}
+
+/* * * * * * * * * * * * * * * * * * * *
+ * Incremental parsing
+ */
+
+/* is_scalar_char(c)
+ *
+ * Return true if c may appear in a top-level number or literal.
+ */
+static inline bool is_scalar_char(char c) {
+    return in_range(c, '0', '9') || in_range(c, 'a', 'z') || in_range(c, 'A', 'Z')
+           || c == '-' || c == '+' || c == '.';
+}
+
+JsonStreamParser::JsonStreamParser()
+    : m_scanned(0), m_start(string::npos), m_depth(0), m_in_string(false), m_escaped(false) {}
+
+bool JsonStreamParser::feed(const char *data, size_t len) {
+    if (failed())
+        return false;
+
+    m_buffer.append(data, len);
+    scan();
+    return !failed();
+}
+
+bool JsonStreamParser::finish() {
+    if (failed())
+        return false;
+
+    if (m_start != string::npos) {
+        if (m_depth > 0 || m_in_string)
+            m_error = "unexpected end of input";
+        else
+            complete(m_buffer.size());
+    }
+    return !failed();
+}
+
+bool JsonStreamParser::next(Json &out) {
+    if (m_values.empty())
+        return false;
+
+    out = move(m_values.front());
+    m_values.pop_front();
+    return true;
+}
+
+/* scan()
+ *
+ * Advance the scanner over the unseen part of the buffer, handing each value that it finds
+ * the end of to complete(). The scanner only tracks strings and nesting; the parser does the
+ * validation.
+ */
+void JsonStreamParser::scan() {
+    while (m_scanned < m_buffer.size() && !failed()) {
+        const char ch = m_buffer[m_scanned];
+
+        if (m_start == string::npos) {
+            m_scanned++;
+            if (is_whitespace(ch))
+                continue;
+
+            m_start = m_scanned - 1;
+            if (ch == '{' || ch == '[')
+                m_depth = 1;
+            else if (ch == '"')
+                m_in_string = true;
+            else if (!is_scalar_char(ch))
+                complete(m_scanned); // Let the parser report the stray character
+        } else if (m_in_string) {
+            m_scanned++;
+            if (m_escaped) {
+                m_escaped = false;
+            } else if (ch == '\\') {
+                m_escaped = true;
+            } else if (ch == '"') {
+                m_in_string = false;
+                if (m_depth == 0)
+                    complete(m_scanned);
+            }
+        } else if (m_depth > 0) {
+            m_scanned++;
+            if (ch == '"') {
+                m_in_string = true;
+            } else if (ch == '{' || ch == '[') {
+                m_depth++;
+            } else if (ch == '}' || ch == ']') {
+                if (--m_depth == 0)
+                    complete(m_scanned);
+            }
+        } else if (is_scalar_char(ch)) {
+            m_scanned++;
+        } else {
+            // The end of a top-level number or literal; ch starts whatever comes next.
+            complete(m_scanned);
+        }
+    }
+
+    // Drop consumed input once it is at least half the buffer, so trimming stays linear.
+    const size_t consumed = m_start != string::npos ? m_start : m_scanned;
+    if (consumed > 0 && consumed >= m_buffer.size() / 2) {
+        m_buffer.erase(0, consumed);
+        m_scanned -= consumed;
+        if (m_start != string::npos)
+            m_start -= consumed;
+    }
+}
+
+/* complete(end)
+ *
+ * Parse the value in progress, which ends at offset end.
+ */
+void JsonStreamParser::complete(size_t end) {
+    Json value = parse_document(m_buffer.data() + m_start, end - m_start, m_error, nullptr, false);
+    if (!failed())
+        m_values.push_back(move(value));
+    m_start = string::npos;
+    m_depth = 0;
+}
+
+/* * * * * * * * * * * * * * * * * * * *
+ * CBOR
+ *
+ * The subset of RFC 8949 that maps onto JSON: integers, floats, text strings, arrays, maps
+ * with text keys, and the simple values false, true and null.
+ */
+
+enum CborMajor : uint8_t {
+    CBOR_UNSIGNED = 0, CBOR_NEGATIVE = 1, CBOR_BYTES = 2, CBOR_TEXT = 3,
+    CBOR_ARRAY = 4, CBOR_MAP = 5, CBOR_TAG = 6, CBOR_SIMPLE = 7
+};
+
+// Write the head of an item: its major type and argument, in the shortest form.
+static void write_cbor_head(JsonWriter &out, CborMajor major, uint64_t arg) {
+    char buf[9];
+    size_t len;
+    const char type = static_cast<char>(major << 5);
+    if (arg < 24) {
+        buf[0] = static_cast<char>(type | arg);
+        len = 1;
+    } else if (arg <= 0xff) {
+        buf[0] = static_cast<char>(type | 24);
+        len = 2;
+    } else if (arg <= 0xffff) {
+        buf[0] = static_cast<char>(type | 25);
+        len = 3;
+    } else if (arg <= 0xffffffff) {
+        buf[0] = static_cast<char>(type | 26);
+        len = 5;
+    } else {
+        buf[0] = static_cast<char>(type | 27);
+        len = 9;
+    }
+    for (size_t i = len - 1; i > 0; i--, arg >>= 8)
+        buf[i] = static_cast<char>(arg & 0xff);
+    out.append(buf, len);
+}
+
+static void write_cbor_string(JsonWriter &out, const string &value) {
+    write_cbor_head(out, CBOR_TEXT, value.size());
+    out.append(value.data(), value.size());
+}
+
+void JsonWriter::write_cbor(const Json &value) {
+    switch (value.m_repr) {
+    case Json::REPR_NULL:
+        *this += '\xf6';
+        return;
+    case Json::REPR_BOOL:
+        *this += value.m_bool ? '\xf5' : '\xf4';
+        return;
+    case Json::REPR_INT:
+        if (value.m_int >= 0)
+            write_cbor_head(*this, CBOR_UNSIGNED, static_cast<uint64_t>(value.m_int));
+        else
+            write_cbor_head(*this, CBOR_NEGATIVE, static_cast<uint64_t>(-1 - static_cast<int64_t>(value.m_int)));
+        return;
+    case Json::REPR_DOUBLE: {
+        // A single-precision float where that is exact, which keeps small doubles short.
+        const float narrow = static_cast<float>(value.m_double);
+        if (static_cast<double>(narrow) == value.m_double || value.m_double != value.m_double) {
+            uint32_t bits;
+            memcpy(&bits, &narrow, sizeof bits);
+            *this += '\xfa';
+            for (int shift = 24; shift >= 0; shift -= 8)
+                *this += static_cast<char>((bits >> shift) & 0xff);
+        } else {
+            const uint64_t bits = double_to_bits(value.m_double);
+            *this += '\xfb';
+            for (int shift = 56; shift >= 0; shift -= 8)
+                *this += static_cast<char>((bits >> shift) & 0xff);
+        }
+        return;
+    }
+    case Json::REPR_VALUE:
+        break;
+    }
+
+    switch (value.type()) {
+    case Json::STRING:
+        write_cbor_string(*this, value.string_value());
+        break;
+    case Json::ARRAY:
+        write_cbor_head(*this, CBOR_ARRAY, value.array_items().size());
+        for (const auto &item : value.array_items())
+            write_cbor(item);
+        break;
+    case Json::OBJECT:
+        write_cbor_head(*this, CBOR_MAP, value.object_items().size());
+        for (const auto &kv : value.object_items()) {
+            write_cbor_string(*this, kv.first);
+            write_cbor(kv.second);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void Json::dump_cbor(string &out) const {
+    JsonWriter writer(out);
+    writer.write_cbor(*this);
+}
+
+void Json::dump_cbor(JsonSink &sink) const {
+    JsonWriter writer(sink);
+    writer.write_cbor(*this);
+    writer.flush();
+}
+
+// Decode an IEEE754 half-precision float.
+static double half_to_double(uint16_t half) {
+    const int exponent = (half >> 10) & 0x1f;
+    const int mantissa = half & 0x3ff;
+    double value;
+    if (exponent == 0)
+        value = std::ldexp(mantissa, -24);
+    else if (exponent != 31)
+        value = std::ldexp(mantissa + 1024, exponent - 25);
+    else
+        value = mantissa == 0 ? std::numeric_limits<double>::infinity()
+                              : std::numeric_limits<double>::quiet_NaN();
+    return (half & 0x8000) ? -value : value;
+}
+
+/* CborParser
+ *
+ * Object that tracks all state of an in-progress CBOR parse.
+ */
+struct CborParser final {
+    const uint8_t *pos;
+    const uint8_t *end;
+    string &err;
+    bool failed;
+
+    Json fail(string &&msg) {
+        if (!failed)
+            err = std::move(msg);
+        failed = true;
+        return Json();
+    }
+
+    // Read n big-endian bytes into out. Return false at the end of the input.
+    bool read_uint(size_t n, uint64_t &out) {
+        if (static_cast<size_t>(end - pos) < n)
+            return false;
+        out = 0;
+        for (size_t i = 0; i < n; i++)
+            out = (out << 8) | *pos++;
+        return true;
+    }
+
+    /* read_head(major, info, arg)
+     *
+     * Read the head of the next item. Return false, having called fail(), if it is truncated
+     * or has an indefinite length.
+     */
+    bool read_head(uint8_t &major, uint8_t &info, uint64_t &arg) {
+        if (pos == end) {
+            fail("unexpected end of CBOR input");
+            return false;
+        }
+        major = *pos >> 5;
+        info = *pos & 0x1f;
+        pos++;
+        if (info < 24) {
+            arg = info;
+            return true;
+        }
+        if (info > 27) {
+            fail(info == 31 ? "indefinite-length CBOR items are not supported"
+                            : "invalid CBOR additional information " + std::to_string(info));
+            return false;
+        }
+        if (!read_uint(size_t(1) << (info - 24), arg)) {
+            fail("unexpected end of CBOR input");
+            return false;
+        }
+        return true;
+    }
+
+    bool read_text(uint64_t len, string &out) {
+        if (static_cast<uint64_t>(end - pos) < len) {
+            fail("unexpected end of CBOR input in string");
+            return false;
+        }
+        out = string(reinterpret_cast<const char *>(pos), static_cast<size_t>(len));
+        pos += len;
+        return true;
+    }
+
+    Json parse_item(int depth) {
+        if (depth > max_depth)
+            return fail("exceeded maximum nesting depth");
+
+        uint8_t major, info;
+        uint64_t arg;
+        if (!read_head(major, info, arg))
+            return Json();
+
+        switch (major) {
+        case CBOR_UNSIGNED:
+            if (arg <= static_cast<uint64_t>(std::numeric_limits<int>::max()))
+                return Json(static_cast<int>(arg));
+            return Json(static_cast<double>(arg));
+        case CBOR_NEGATIVE:
+            if (arg <= static_cast<uint64_t>(std::numeric_limits<int>::max()))
+                return Json(-1 - static_cast<int>(arg));
+            return Json(-1.0 - static_cast<double>(arg));
+        case CBOR_BYTES:
+            return fail("CBOR byte strings are not supported");
+        case CBOR_TEXT: {
+            string text;
+            if (!read_text(arg, text))
+                return Json();
+            return Json(std::move(text));
+        }
+        case CBOR_ARRAY: {
+            Json::array data;
+            // Every item takes at least one byte, which bounds the reservation.
+            data.reserve(static_cast<size_t>(std::min<uint64_t>(arg, end - pos)));
+            for (uint64_t n = 0; n < arg; n++) {
+                data.push_back(parse_item(depth + 1));
+                if (failed)
+                    return Json();
+            }
+            return Json(std::move(data));
+        }
+        case CBOR_MAP: {
+            Json::object data;
+            for (uint64_t n = 0; n < arg; n++) {
+                uint8_t key_major, key_info;
+                uint64_t key_len;
+                if (!read_head(key_major, key_info, key_len))
+                    return Json();
+                if (key_major != CBOR_TEXT)
+                    return fail("CBOR map keys must be text strings");
+                string key;
+                if (!read_text(key_len, key))
+                    return Json();
+                data[std::move(key)] = parse_item(depth + 1);
+                if (failed)
+                    return Json();
+            }
+            return Json(std::move(data));
+        }
+        case CBOR_TAG:
+            // Tags only annotate the item that follows, which is all JSON can represent.
+            return parse_item(depth + 1);
+        default:
+            break;
+        }
+
+        switch (info) {
+        case 20: return Json(false);
+        case 21: return Json(true);
+        case 22:
+        case 23: return Json(nullptr);
+        case 25: return Json(half_to_double(static_cast<uint16_t>(arg)));
+        case 26: {
+            const uint32_t bits = static_cast<uint32_t>(arg);
+            float value;
+            memcpy(&value, &bits, sizeof value);
+            return Json(static_cast<double>(value));
+        }
+        case 27: return Json(bits_to_double(arg));
+        default:
+            return fail("unsupported CBOR simple value " + std::to_string(arg));
+        }
+    }
+};
+
+Json Json::parse_cbor(const char *in, size_t len, string &err) {
+    const uint8_t *data = reinterpret_cast<const uint8_t *>(in);
+    CborParser parser { data, data + len, err, false };
+    Json result = parser.parse_item(0);
+    if (parser.failed)
+        return Json();
+    if (parser.pos != parser.end)
+        return parser.fail("unexpected trailing bytes after CBOR item");
+    return result;
+}
+
+Json Json::parse_cbor(const string &in, string &err) {
+    return parse_cbor(in.data(), in.size(), err);
 }
 
 /* * * * * * * * * * * * * * * * * * * *
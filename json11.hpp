@@ -10,8 +10,8 @@
  * order, etc. There are also helper methods Json::dump, to serialize a Json to a string, and
  * Json::parse (static) to parse a std::string as a Json object.
  *
- * Internally, the various types of Json object are represented by the JsonValue class
- * hierarchy.
+ * Internally, null, booleans and numbers are stored inline in the Json itself, and strings,
+ * arrays and objects are represented by the JsonValue class hierarchy.
  *
  * A note on numbers - JSON specifies the syntax of number formatting but not its semantics,
  * so some JSON implementations distinguish between integers and floating-point numbers, while
@@ -50,20 +50,39 @@
 
 #pragma once
 
+#include <cstdio>
+#include <iosfwd>
 #include <string>
 #include <vector>
+#include <deque>
 #include <map>
+#include <algorithm>
+#include <functional>
 #include <memory>
+#include <new>
 #include <initializer_list>
 
 namespace json11 {
 
 class Json;
 class JsonValue;
+class Arena;
+class JsonAllocator;
+class JsonHandler;
+class JsonSink;
+class JsonWriter;
+struct JsonParser;
 
 namespace detail
 {
 
+/* A visitor that accepts any field, for detecting json_fields. */
+struct FieldProbe
+{
+    template<class F>
+    void operator()(const char*, F&) {}
+};
+
 /* A helper class for implementing the traits below. */
 struct TraitsHelpers
 {
@@ -71,6 +90,8 @@ struct TraitsHelpers
     static std::false_type test_free_encode(...);
     static std::false_type test_member_decode(...);
     static std::false_type test_free_decode(...);
+    static std::false_type test_mapped_type(...);
+    static std::false_type test_json_fields(...);
 
     template<class S>
     static std::true_type test_member_encode(
@@ -95,6 +116,18 @@ struct TraitsHelpers
         const S&,
         decltype(from_json(std::declval<Json>(), std::declval<S&>()))* = 0
     );
+
+    template<class S>
+    static std::true_type test_mapped_type(
+        const S&,
+        typename S::mapped_type* = 0
+    );
+
+    template<class S>
+    static std::true_type test_json_fields(
+        const S&,
+        decltype(std::declval<S&>().json_fields(std::declval<FieldProbe&>()))* = 0
+    );
     
 };
 
@@ -172,8 +205,231 @@ struct has_from_json :
     >
 { };
 
+/* Inherits from std::true_type if T is a map, i.e. has a mapped_type. */
+template<class T>
+struct has_mapped_type :
+    decltype(TraitsHelpers::test_mapped_type(std::declval<T>()))
+{
+};
+
+/*
+ * Inherits from std::true_type if Json::as<T> should decode T as a sequence of the
+ * items of an array: it has no from_json, and is neither a string nor a map.
+ */
+template<class T>
+struct is_json_sequence :
+    std::integral_constant<
+        bool,
+        !has_from_json<T>::value && !std::is_same<T, std::string>::value
+            && !has_mapped_type<T>::value
+    >
+{ };
+
+/*
+ * Inherits from std::true_type if t.json_fields(visitor) is a valid expression, i.e. T
+ * lists its fields for JsonReader.
+ */
+template<class T>
+struct has_json_fields :
+    decltype(TraitsHelpers::test_json_fields(std::declval<T>()))
+{
+};
+
+/* Call c.reserve(n) if T has it, as std::vector and std::string do. */
+template<class T>
+auto reserve_if_possible(T& c, size_t n, int) -> decltype(c.reserve(n), void())
+{
+    c.reserve(n);
 }
 
+template<class T>
+void reserve_if_possible(T&, size_t, long)
+{
+}
+
+/* A borrowed string key, which orders against std::string without being copied into one. */
+struct key_view
+{
+    const char *data;
+    size_t size;
+};
+
+inline bool operator<(const std::string &a, const key_view &b) { return a.compare(0, a.size(), b.data, b.size) < 0; }
+inline bool operator<(const key_view &a, const std::string &b) { return b.compare(0, b.size(), a.data, a.size) > 0; }
+
+}
+
+/* flat_map<K, V>
+ *
+ * A map kept as a sorted std::vector of pairs, with the subset of the std::map interface
+ * that Json::object is used through. Lookups are a binary search over contiguous storage,
+ * and there is no per-entry allocation, which suits the small objects that dominate most
+ * JSON. Unlike std::map, insertion and erasure are linear and invalidate iterators.
+ *
+ * Json::object uses this in place of std::map if JSON11_FLAT_OBJECT is defined. Iteration
+ * is in key order either way, so comparison and serialization are unaffected.
+ */
+template <class K, class V>
+class flat_map {
+public:
+    typedef K key_type;
+    typedef V mapped_type;
+    typedef std::pair<K, V> value_type;
+    typedef std::less<K> key_compare;
+    typedef typename std::vector<value_type>::size_type size_type;
+    typedef typename std::vector<value_type>::iterator iterator;
+    typedef typename std::vector<value_type>::const_iterator const_iterator;
+
+    flat_map() {}
+
+    // As with std::map, the first of several entries with the same key wins.
+    template <class It>
+    flat_map(It first, It last) {
+        for (; first != last; ++first)
+            m_items.emplace_back(first->first, first->second);
+        std::stable_sort(m_items.begin(), m_items.end(), compare_entries);
+        m_items.erase(std::unique(m_items.begin(), m_items.end(), same_key), m_items.end());
+    }
+    flat_map(std::initializer_list<value_type> items) : flat_map(items.begin(), items.end()) {}
+
+    iterator begin()             { return m_items.begin(); }
+    iterator end()               { return m_items.end(); }
+    const_iterator begin() const { return m_items.begin(); }
+    const_iterator end() const   { return m_items.end(); }
+
+    bool empty() const     { return m_items.empty(); }
+    size_type size() const { return m_items.size(); }
+    void clear()           { m_items.clear(); }
+
+    iterator lower_bound(const K &key) {
+        return std::lower_bound(m_items.begin(), m_items.end(), key, compare_key);
+    }
+    const_iterator lower_bound(const K &key) const {
+        return std::lower_bound(m_items.begin(), m_items.end(), key, compare_key);
+    }
+
+    iterator find(const K &key) {
+        iterator it = lower_bound(key);
+        return (it != end() && !(key < it->first)) ? it : end();
+    }
+    const_iterator find(const K &key) const {
+        const_iterator it = lower_bound(key);
+        return (it != end() && !(key < it->first)) ? it : end();
+    }
+    size_type count(const K &key) const { return find(key) != end() ? 1 : 0; }
+
+    // Look up a key of another type that orders against K, such as detail::key_view.
+    template <class Key, typename std::enable_if<!std::is_convertible<Key, K>::value, int>::type = 0>
+    const_iterator find(const Key &key) const {
+        const_iterator it = std::lower_bound(m_items.begin(), m_items.end(), key,
+                                             [](const value_type &a, const Key &b) { return a.first < b; });
+        return (it != end() && !(key < it->first)) ? it : end();
+    }
+
+    V & operator[](const K &key) { return insert(value_type(key, V())).first->second; }
+    V & operator[](K &&key)      { return insert(value_type(std::move(key), V())).first->second; }
+
+    std::pair<iterator, bool> insert(value_type &&item) {
+        // Appending in key order is the common case, and costs no search.
+        iterator it = (m_items.empty() || m_items.back().first < item.first)
+                          ? m_items.end() : lower_bound(item.first);
+        if (it != m_items.end() && !(item.first < it->first))
+            return std::make_pair(it, false);
+        return std::make_pair(m_items.insert(it, std::move(item)), true);
+    }
+    std::pair<iterator, bool> insert(const value_type &item) {
+        return insert(value_type(item));
+    }
+    template <class... Args>
+    std::pair<iterator, bool> emplace(Args &&... args) {
+        return insert(value_type(std::forward<Args>(args)...));
+    }
+
+    iterator erase(const_iterator it) { return m_items.erase(it); }
+    size_type erase(const K &key) {
+        iterator it = find(key);
+        if (it == end())
+            return 0;
+        m_items.erase(it);
+        return 1;
+    }
+
+    bool operator==(const flat_map &other) const { return m_items == other.m_items; }
+    bool operator!=(const flat_map &other) const { return m_items != other.m_items; }
+    bool operator<(const flat_map &other) const  { return m_items < other.m_items; }
+
+private:
+    static bool compare_entries(const value_type &a, const value_type &b) { return a.first < b.first; }
+    static bool compare_key(const value_type &a, const K &key) { return a.first < key; }
+    static bool same_key(const value_type &a, const value_type &b) { return !(a.first < b.first); }
+
+    std::vector<value_type> m_items;
+};
+
+/* intrusive_ptr<T>
+ *
+ * A pointer to a JsonValue whose reference count lives in the value itself and is updated
+ * with plain, non-atomic arithmetic. Json uses it in place of std::shared_ptr if
+ * JSON11_NONATOMIC_REFCOUNT is defined, which makes copying a Json much cheaper, but then a
+ * value - including every Json that shares it - may only be used by one thread at a time.
+ */
+#ifdef JSON11_NONATOMIC_REFCOUNT
+inline void intrusive_add_ref(const JsonValue * value) noexcept;
+inline void intrusive_release(const JsonValue * value) noexcept;
+inline long intrusive_use_count(const JsonValue * value) noexcept;
+
+template <class T>
+class intrusive_ptr {
+public:
+    intrusive_ptr() noexcept : m_ptr(nullptr) {}
+    // Adopt a newly created value, which starts with a count of one.
+    explicit intrusive_ptr(T * ptr) noexcept : m_ptr(ptr) {}
+
+    intrusive_ptr(const intrusive_ptr & other) noexcept : m_ptr(other.m_ptr) {
+        if (m_ptr)
+            intrusive_add_ref(m_ptr);
+    }
+    intrusive_ptr(intrusive_ptr && other) noexcept : m_ptr(other.m_ptr) { other.m_ptr = nullptr; }
+    ~intrusive_ptr() {
+        if (m_ptr)
+            intrusive_release(m_ptr);
+    }
+    intrusive_ptr & operator=(intrusive_ptr other) noexcept {
+        std::swap(m_ptr, other.m_ptr);
+        return *this;
+    }
+
+    T * get() const noexcept { return m_ptr; }
+    T & operator*() const noexcept { return *m_ptr; }
+    T * operator->() const noexcept { return m_ptr; }
+    explicit operator bool() const noexcept { return m_ptr != nullptr; }
+    long use_count() const noexcept { return m_ptr ? intrusive_use_count(m_ptr) : 0; }
+
+private:
+    T * m_ptr;
+};
+#endif
+
+namespace detail {
+
+#ifdef JSON11_NONATOMIC_REFCOUNT
+typedef intrusive_ptr<JsonValue> value_ptr;
+
+// The count and the allocation a JsonValue came from.
+struct RefCounted {
+    mutable long m_refs = 1;
+    JsonAllocator * m_allocator = nullptr;
+    unsigned m_alloc_size = 0;
+    unsigned m_alloc_align = 0;
+};
+#else
+typedef std::shared_ptr<JsonValue> value_ptr;
+
+struct RefCounted {};
+#endif
+
+} // namespace detail
+
 class Json final {
 public:
     // Types
@@ -183,7 +439,11 @@ public:
 
     // Array and object typedefs
     typedef std::vector<Json> array;
+#ifdef JSON11_FLAT_OBJECT
+    typedef flat_map<std::string, Json> object;
+#else
     typedef std::map<std::string, Json> object;
+#endif
 
     // Constructors for the various types of JSON value.
     Json() noexcept;                // NUL
@@ -227,6 +487,26 @@ public:
     // Json(bool(some_pointer)) if that behavior is desired.
     Json(void *) = delete;
 
+    // Copying and moving, which must know which member of the representation is live.
+    Json(const Json & other) noexcept : m_repr(other.m_repr) { copy_repr(other); }
+    Json(Json && other) noexcept : m_repr(other.m_repr) { move_repr(other); }
+    Json & operator=(const Json & other) noexcept {
+        // Copy first: other may be part of the value this is about to release.
+        Json copy(other);
+        return *this = std::move(copy);
+    }
+    Json & operator=(Json && other) noexcept {
+        if (this != &other) {
+            // Take other first, for the same reason.
+            Json taken(std::move(other));
+            destroy_repr();
+            m_repr = taken.m_repr;
+            move_repr(taken);
+        }
+        return *this;
+    }
+    ~Json() { destroy_repr(); }
+
     // Accessors
     Type type() const;
 
@@ -249,7 +529,7 @@ public:
     const std::string &string_value() const;
     // Return the enclosed std::vector if this is an array, or an empty vector otherwise.
     const array &array_items() const;
-    // Return the enclosed std::map if this is an object, or an empty map otherwise.
+    // Return the enclosed map if this is an object, or an empty map otherwise.
     const object &object_items() const;
 
     // Return a reference to arr[i] if this is an array, Json() otherwise.
@@ -257,6 +537,73 @@ public:
     // Return a reference to obj[key] if this is an object, Json() otherwise.
     const Json & operator[](const std::string &key) const;
 
+    /* get(key, len)
+     *
+     * Return a reference to obj[key] if this is an object, Json() otherwise, looking up the
+     * len bytes at key without building a std::string for them. operator[] takes C strings
+     * the same way; it is a template so that json[0] still means the first array item.
+     */
+    const Json & get(const char *key, size_t len) const;
+    template <class T, typename std::enable_if<std::is_same<T, const char *>::value
+                                               || std::is_same<T, char *>::value, int>::type = 0>
+    const Json & operator[](T key) const { return get(key, std::char_traits<char>::length(key)); }
+
+    /* Editing
+     *
+     * Copies of a Json share their value, so an edit copies any array or object on its way
+     * that something else also refers to, and changes the rest in place. Changing one field
+     * deep in a large document copies one node per level, never whole branches. Editing a
+     * null Json first turns it into an empty object or array, as the edit needs.
+     */
+
+    // Set obj[key] to value. Return false if this is not an object.
+    bool set(const std::string &key, Json value);
+    // Append value. Return false if this is not an array.
+    bool push_back(Json value);
+    // Remove obj[key] or arr[index]. Return false if there was nothing to remove.
+    bool erase(const std::string &key);
+    bool erase(size_t index);
+
+    /* Path
+     *
+     * A compiled JSON Pointer (RFC 6901) such as "/servers/0/port", or simple JSONPath such as
+     * "$.servers[0].port" or "$['a key']". Its steps are split, unescaped and parsed into array
+     * indices once, so evaluating it many times needs no temporary strings.
+     */
+    class Path;
+
+    // Return the value that path refers to, or a null Json if there is none.
+    const Json & at(const Path & path) const;
+
+    /* set_path(path, value, err)
+     *
+     * Set the value that path refers to. The last step may name a new object key, or "-" or
+     * the size of an array to append. Return false and set err if the path is malformed or a
+     * step before the last is missing. Unlike set() and push_back(), this never creates
+     * containers: a null on the way, including a null this, is an error like any other
+     * scalar, so a failed set_path leaves the value as it was.
+     */
+    bool set_path(const Path & path, Json value, std::string & err);
+    bool set_path(const std::string & pointer, Json value, std::string & err);
+
+    /* extract(in, path, err)
+     *
+     * Return parse(in, err).at(path), but without building anything other than the value at
+     * path: the rest of in is only validated. Return Json() and set err if in is not valid
+     * JSON, and Json() alone if there is no such value. As in parse(), the last of duplicate
+     * keys wins.
+     */
+    static Json extract(const std::string & in, const Path & path, std::string & err);
+
+    /* fragment(value)
+     *
+     * Return value with its serialized form kept alongside, for response skeletons and other
+     * fixed fragments: dumping it, or any document it is part of, copies those bytes instead
+     * of walking value again. Build it once, for example as a function-local static, and
+     * share it. It reads and compares like value; editing it edits a copy.
+     */
+    static Json fragment(Json value);
+
     // Serialize.
     void dump(std::string &out) const;
     std::string dump() const {
@@ -265,19 +612,174 @@ public:
         return out;
     }
 
+    /* dump(sink)
+     *
+     * Serialize to sink through a fixed-size buffer, so that the output is never held in
+     * memory as a whole. Produces exactly the same bytes as dump().
+     */
+    void dump(JsonSink &sink) const;
+
+    /* DumpOptions
+     *
+     * The layout of dump(out, options). compact leaves out the space after ':' and ','.
+     * A nonzero indent puts each array item and object member on a line of its own, indented
+     * by that many spaces per level of nesting; empty arrays and objects stay [] and {}.
+     * Object members come out in key order with either object backend. The default options
+     * produce the same bytes as dump().
+     */
+    struct DumpOptions {
+        explicit DumpOptions(bool compact = false, unsigned indent = 0)
+            : compact(compact), indent(indent) {}
+        bool compact;
+        unsigned indent;
+    };
+
+    // Serialize with options, in a single pass. Only the default layout uses the size and
+    // dump caches and the saved text of fragments, since they hold default-layout bytes.
+    void dump(std::string & out, const DumpOptions & options) const;
+    std::string dump(const DumpOptions & options) const {
+        std::string out;
+        dump(out, options);
+        return out;
+    }
+    void dump(JsonSink & sink, const DumpOptions & options) const;
+
+    /* serialized_size()
+     *
+     * Return the exact number of bytes dump() produces. Arrays and objects remember their
+     * size once it has been computed, so asking again for a shared subtree is free. If the
+     * size of the whole value is known that way, dump() reserves its output once; it never
+     * computes the size just for that, which would cost as much as the dump itself.
+     */
+    size_t serialized_size() const;
+
+    /* set_dump_cache_limit(bytes)
+     *
+     * Opt in to caching serialized output. Once enabled, an array or object that is shared by
+     * more than one Json keeps a copy of its output from the first dump, and later dumps
+     * append that copy in one piece. At most bytes bytes are cached in total; beyond that,
+     * nodes are dumped as usual. The default, 0, disables the cache. Lowering the limit does
+     * not free anything: cached bytes are released together with their nodes.
+     */
+    static void set_dump_cache_limit(size_t bytes);
+    // Return the number of bytes currently held by the dump cache.
+    static size_t dump_cache_size();
+
+    /* dump_cbor(), parse_cbor(in, err)
+     *
+     * Serialize to and parse from CBOR (RFC 8949), a binary encoding that needs no number
+     * formatting or string escaping. Ints and doubles keep their types: ints become CBOR
+     * integers and doubles CBOR floats, single-precision where that is exact. parse_cbor
+     * accepts definite-length items, skips tags, and fails on byte strings and non-text keys.
+     */
+    void dump_cbor(std::string &out) const;
+    std::string dump_cbor() const {
+        std::string out;
+        dump_cbor(out);
+        return out;
+    }
+    void dump_cbor(JsonSink &sink) const;
+    static Json parse_cbor(const std::string & in, std::string & err);
+    static Json parse_cbor(const char * in, size_t len, std::string & err);
+
     // Parse. If parse fails, return Json() and assign an error message to err.
     static Json parse(const std::string & in, std::string & err);
     static Json parse(const char * in, std::string & err) {
         if (in) {
-            return parse(std::string(in), err);
+            return parse(in, std::char_traits<char>::length(in), err);
         } else {
             err = "null input";
             return nullptr;
         }
     }
+    // Parse len bytes starting at in, which need not be NUL-terminated.
+    static Json parse(const char * in, size_t len, std::string & err);
+    // Like parse(in, len, err), but without copying strings: string values refer to the input
+    // and are only decoded the first time string_value() is called, so in (for example, a
+    // memory-mapped file) must outlive the result.
+    static Json parse_view(const char * in, size_t len, std::string & err);
+    // Like parse_view, but also lazy about arrays and objects. The whole input is validated and
+    // the extent of every container indexed up front; after that, an array or object is only
+    // parsed, one level at a time, when its items are first read. Subtrees that are never
+    // visited cost no more than the validation pass.
+    static Json parse_lazy(const char * in, size_t len, std::string & err);
+
+    // Parse, reporting each value to handler as it is read instead of building a Json; memory
+    // use does not grow with the size of the input. Return true if the whole input was parsed.
+    // On a syntax error, return false and assign an error message to err; if the handler stops
+    // the parse by returning false, return false and leave err alone.
+    static bool parse(const char * in, size_t len, JsonHandler & handler, std::string & err);
+    static bool parse(const std::string & in, JsonHandler & handler, std::string & err) {
+        return parse(in.data(), in.size(), handler, err);
+    }
+
     // Parse multiple objects, concatenated or separated by whitespace
     static std::vector<Json> parse_multi(const std::string & in, std::string & err);
 
+    // Parse newline-delimited JSON on several threads. The input is split at line boundaries
+    // and the pieces are parsed concurrently, so no value may span lines (NDJSON forbids it
+    // anyway). For such input the result and err are exactly those of parse_multi(in, err):
+    // values come back in input order, and err describes the first failure. threads == 0
+    // means one thread per hardware thread.
+    static std::vector<Json> parse_ndjson(const std::string & in, std::string & err,
+                                          unsigned threads = 0);
+
+    // As above, but hand the work to run as up to `pieces` tasks. run may execute each task
+    // on any thread, but must eventually execute all of them; the call blocks until it has.
+    typedef std::function<void(std::function<void()>)> executor;
+    static std::vector<Json> parse_ndjson(const std::string & in, std::string & err,
+                                          const executor & run, size_t pieces);
+
+    // Serialize on several threads, splitting the items of a large top-level array or object
+    // into consecutive pieces that are dumped concurrently and then joined in order. The
+    // result is exactly that of dump(out). threads == 0 means one per hardware thread.
+    void dump_parallel(std::string & out, unsigned threads = 0) const;
+    // As above, but hand the work to run as up to `pieces` tasks, as for parse_ndjson.
+    void dump_parallel(std::string & out, const executor & run, size_t pieces) const;
+
+    // Parse, taking the storage for every value in the result from allocator (such as an
+    // Arena). It must outlive the result and every Json that shares a value with it.
+    static Json parse(const std::string & in, std::string & err, JsonAllocator & allocator);
+
+    /* Parser
+     *
+     * Parses documents one after another like parse(in, err), but keeps the buffers it
+     * decodes escaped strings and collects array items into between calls. Once they have
+     * grown to fit, parsing small documents allocates nothing beyond the result itself.
+     */
+    class Parser;
+
+#ifdef JSON11_STATS
+    /* Stats
+     *
+     * What parsing or dumping one document cost, for finding pathological payloads. Only
+     * built with JSON11_STATS, so that the counting costs nothing otherwise.
+     */
+    struct Stats {
+        size_t values[OBJECT + 1] = {};     // Values parsed, by Type
+        int peak_depth = 0;                 // Deepest nesting reached; 0 for a scalar document
+        size_t allocated_bytes = 0;         // Estimated heap bytes of the parsed values
+        size_t unescaped_bytes = 0;         // Decoded bytes of strings that had escapes
+        double parse_seconds = 0;
+        size_t dumped_bytes = 0;
+        double dump_seconds = 0;
+    };
+
+    // Parse as parse(in, err) does, adding what it cost to stats.
+    static Json parse(const std::string & in, std::string & err, Stats & stats);
+    // Serialize as dump(out) does, adding what it cost to stats.
+    void dump(std::string & out, Stats & stats) const;
+#endif
+
+    /* set_allocator(allocator)
+     *
+     * Take the storage for every string, array and object value created from now on, by
+     * constructors and parsing alike, from allocator; nullptr restores the default of
+     * std::allocator. Values keep the allocator they were created with, so it must outlive
+     * all of them.
+     */
+    static void set_allocator(JsonAllocator * allocator);
+
     /* Converts a Json object to type T if T has a from_json method. */
     template<class T>
     T as(typename std::enable_if<
@@ -302,22 +804,112 @@ public:
         return result;
     }
 
+    /* Converts a Json number or bool to an arithmetic type T. */
+    template<class T>
+    T as(typename std::enable_if<
+            std::is_arithmetic<T>::value && !detail::has_from_json<T>::value
+        >::type* = 0) const
+    {
+        return static_cast<T>(std::is_same<T, bool>::value ? bool_value() : number_value());
+    }
+
+    /*
+     * Converts a Json string to std::string. On an rvalue whose string is not shared, the
+     * string is moved out rather than copied.
+     */
+    template<class T>
+    T as(typename std::enable_if<std::is_same<T, std::string>::value>::type* = 0) const &
+    {
+        return string_value();
+    }
+
+    template<class T>
+    T as(typename std::enable_if<std::is_same<T, std::string>::value>::type* = 0) &&
+    {
+        if (std::string *value = unique_string())
+            return std::move(*value);
+        return string_value();
+    }
+
+    /* Converts a Json object to a map from strings to values of the map's mapped_type. */
+    template<class T>
+    T as(typename std::enable_if<
+            detail::has_mapped_type<T>::value && !detail::has_from_json<T>::value
+        >::type* = 0) const &
+    {
+        typedef typename T::mapped_type V;
+        T result;
+        for (const auto &kv : object_items())
+            result.emplace_hint(result.end(), kv.first, kv.second.as<V>());
+        return result;
+    }
+
+    template<class T>
+    T as(typename std::enable_if<
+            detail::has_mapped_type<T>::value && !detail::has_from_json<T>::value
+        >::type* = 0) &&
+    {
+        object *items = unique_object();
+        if (!items)
+            return as<T>();
+        typedef typename T::mapped_type V;
+        T result;
+        for (auto &kv : *items)
+            result.emplace_hint(result.end(), kv.first, std::move(kv.second).as<V>());
+        return result;
+    }
+
+    /*
+     * Converts a Json array to a container T of the items, each converted to T's value_type.
+     * On an rvalue whose items are not shared, strings and subarrays are moved out.
+     */
     template<
         class T,
-        class = typename std::enable_if<!detail::has_from_json<T>::value>::type
+        class = typename std::enable_if<detail::is_json_sequence<T>::value>::type
     >
-    T as(decltype(std::declval<T>().begin())* = 0) const
+    T as(decltype(std::declval<T>().begin())* = 0) const &
     {
         typedef decltype(std::declval<T>().begin()) It;
         typedef typename std::iterator_traits<It>::value_type S;
         T result;
-        for (auto js : array_items())
+        detail::reserve_if_possible(result, array_items().size(), 0);
+        for (const auto &js : array_items())
         {
-            result.push_back(js.as<S>());
+            result.insert(result.end(), js.as<S>());
         }
         return result;
     }
-    
+
+    template<
+        class T,
+        class = typename std::enable_if<detail::is_json_sequence<T>::value>::type
+    >
+    T as(decltype(std::declval<T>().begin())* = 0) &&
+    {
+        array *items = unique_array();
+        if (!items)
+            return as<T>();
+        typedef decltype(std::declval<T>().begin()) It;
+        typedef typename std::iterator_traits<It>::value_type S;
+        T result;
+        detail::reserve_if_possible(result, items->size(), 0);
+        for (auto &js : *items)
+        {
+            result.insert(result.end(), std::move(js).as<S>());
+        }
+        return result;
+    }
+
+    /* hash()
+     *
+     * A hash of the value, consistent with operator==: equal values hash the same, including
+     * numbers that compare equal as int and double. Arrays and objects compute theirs once and
+     * keep it until they are next edited. std::hash<Json> calls this.
+     */
+    size_t hash() const;
+
+    // Handles that share a node compare equal without looking inside it, and containers whose
+    // hashes are already known compare unequal without looking inside if those differ.
     bool operator== (const Json &rhs) const;
     bool operator<  (const Json &rhs) const;
     bool operator!= (const Json &rhs) const { return !(*this == rhs); }
@@ -334,28 +926,486 @@ public:
     bool has_shape(const shape & types, std::string & err) const;
 
 private:
-    std::shared_ptr<JsonValue> m_ptr;
+    friend struct JsonParser;
+    friend class JsonWriter;
+    explicit Json(detail::value_ptr ptr) noexcept
+        : m_ptr(std::move(ptr)), m_repr(REPR_VALUE) {}
+
+    // The items of an array or object, copied first unless this is their only reference.
+    array & mutable_array();
+    object & mutable_object();
+    // The items or string of a value that nothing else refers to, or null.
+    array * unique_array();
+    object * unique_object();
+    std::string * unique_string();
+
+    // Which member holds the value. Only strings, arrays and objects need a JsonValue; the
+    // scalars live inline, in the same storage as its pointer, and never allocate.
+    enum Repr : unsigned char {
+        REPR_VALUE, REPR_NULL, REPR_BOOL, REPR_INT, REPR_DOUBLE
+    };
+
+    // Construct the live member from other's, which has the same m_repr. Moving leaves
+    // other null.
+    void copy_repr(const Json & other) noexcept {
+        if (m_repr == REPR_VALUE)
+            new (&m_ptr) detail::value_ptr(other.m_ptr);
+        else
+            copy_scalar(other);
+    }
+    void move_repr(Json & other) noexcept {
+        if (m_repr == REPR_VALUE) {
+            new (&m_ptr) detail::value_ptr(std::move(other.m_ptr));
+            other.destroy_repr();
+            other.m_repr = REPR_NULL;
+        } else {
+            copy_scalar(other);
+        }
+    }
+    void copy_scalar(const Json & other) noexcept {
+        switch (m_repr) {
+        case REPR_BOOL:   m_bool = other.m_bool;      break;
+        case REPR_INT:    m_int = other.m_int;        break;
+        case REPR_DOUBLE: m_double = other.m_double;  break;
+        default:                                      break;
+        }
+    }
+    void destroy_repr() noexcept {
+        typedef detail::value_ptr value_ptr;
+        if (m_repr == REPR_VALUE)
+            m_ptr.~value_ptr();
+    }
+
+    union {
+        detail::value_ptr m_ptr;
+        double m_double;
+        int m_int;
+        bool m_bool;
+    };
+    Repr m_repr;
+};
+
+class Json::Path final {
+public:
+    // The empty path, which refers to the whole document.
+    Path() {}
+
+    // Compile text. If it is malformed, set err and return the empty path.
+    static Path compile(const std::string & text, std::string & err);
+
+    size_t size() const { return m_steps.size(); }
+    const std::string & text() const { return m_text; }
+
+    // An object key, which is also an array index if it spells one.
+    struct Step {
+        static const size_t no_index = size_t(-1);
+        static const size_t end_index = size_t(-2);     // "-", just past the last item
+        std::string key;
+        size_t index;
+    };
+
+private:
+    friend class Json;
+    friend struct JsonParser;
+    std::vector<Step> m_steps;
+    std::string m_text;
+};
+
+class Json::Parser final {
+public:
+    // Take the storage for every parsed value from allocator, or from Json::set_allocator's.
+    explicit Parser(JsonAllocator * allocator = nullptr);
+    Parser(Parser &&) noexcept;
+    Parser & operator=(Parser &&) noexcept;
+    ~Parser();
+
+    Json parse(const std::string & in, std::string & err);
+    Json parse(const char * in, size_t len, std::string & err);
+
+    /* parse(inputs, count, out, errors)
+     *
+     * Parse inputs[0..count) into out[0..count), and their errors into errors[0..count) if it
+     * is not null. A document that fails to parse becomes Json() without stopping the batch.
+     * Return the number of documents that failed.
+     */
+    size_t parse(const std::string * inputs, size_t count, Json * out,
+                 std::string * errors = nullptr);
+
+private:
+    friend struct JsonParser;
+    struct Scratch;
+    std::unique_ptr<Scratch> m_scratch;
+    JsonAllocator * m_allocator;
+};
+
+/* JsonHandler
+ *
+ * Receiver for the events of Json::parse(in, handler, err), in document order. Every callback
+ * returns true to continue or false to stop the parse. The defaults accept and ignore the
+ * event, so a handler only overrides what it needs. Strings passed to on_string and on_key
+ * are only valid for the duration of the call.
+ */
+class JsonHandler {
+public:
+    virtual ~JsonHandler() {}
+
+    virtual bool on_null() { return true; }
+    virtual bool on_bool(bool) { return true; }
+    virtual bool on_number(double) { return true; }
+    // Numbers that Json::parse would store as an int. Forwards to on_number by default.
+    virtual bool on_int(int value) { return on_number(value); }
+    virtual bool on_string(const std::string &) { return true; }
+    virtual bool on_start_array() { return true; }
+    virtual bool on_end_array() { return true; }
+    virtual bool on_start_object() { return true; }
+    virtual bool on_key(const std::string &) { return true; }
+    virtual bool on_end_object() { return true; }
+};
+
+/* JsonReader
+ *
+ * Decodes JSON text straight into C++ values, without building a Json tree. Numbers, bools,
+ * strings, Json, containers of those, and structs that list their fields with json_fields
+ * are supported:
+ *
+ *     struct Point {
+ *         int x = 0, y = 0;
+ *         template <class V> void json_fields(V &v) { v("x", x); v("y", y); }
+ *     };
+ *
+ *     Point p;
+ *     if (!json11::parse_into(text, p, err)) ...
+ *
+ * Keys a struct does not list are skipped without allocating anything, and fields missing
+ * from the input, or null in it, are left as they were; containers are appended to. A value
+ * of the wrong type is an error. The read functions return false once the input is invalid,
+ * with err set as by Json::parse.
+ */
+class JsonReader final {
+public:
+    JsonReader(const char * in, size_t len, std::string & err);
+    JsonReader(const std::string & in, std::string & err) : JsonReader(in.data(), in.size(), err) {}
+    ~JsonReader();
+
+    JsonReader(const JsonReader &) = delete;
+    JsonReader & operator=(const JsonReader &) = delete;
+
+    bool read(double & out);
+    bool read(bool & out);
+    bool read(std::string & out);
+    bool read(Json & out);
+
+    template<class T>
+    bool read(T & out, typename std::enable_if<
+            std::is_arithmetic<T>::value && !std::is_same<T, bool>::value
+        >::type* = 0)
+    {
+        if (read_null())
+            return true;
+        double value = 0;
+        if (!read(value))
+            return false;
+        out = static_cast<T>(value);
+        return true;
+    }
+
+    template<class T>
+    bool read(T & out, typename std::enable_if<detail::has_json_fields<T>::value>::type* = 0)
+    {
+        if (read_null())
+            return true;
+        if (!start_object())
+            return false;
+        while (next_key(m_key)) {
+            FieldReader fields { *this, false };
+            out.json_fields(fields);
+            if (failed() || (!fields.matched && !skip()))
+                return false;
+        }
+        return !failed();
+    }
+
+    template<class T>
+    bool read(T & out, typename std::enable_if<
+            detail::is_json_sequence<T>::value && !detail::has_json_fields<T>::value
+        >::type* = 0, decltype(std::declval<T>().begin())* = 0)
+    {
+        if (read_null())
+            return true;
+        if (!start_array())
+            return false;
+        while (next_item()) {
+            typename T::value_type item;
+            if (!read(item))
+                return false;
+            out.insert(out.end(), std::move(item));
+        }
+        return !failed();
+    }
+
+    /* The building blocks of the reads above, for decoding by hand. */
+
+    // If the next value is null, consume it and return true.
+    bool read_null();
+    // Consume the '{' or '[' that starts an object or array.
+    bool start_object();
+    bool start_array();
+    // Move to the next member of the current object and read its key, or consume the '}' and
+    // return false. Read the member's value (or skip it) before calling next_key again.
+    bool next_key(std::string & key);
+    // Move to the next item of the current array, or consume the ']' and return false.
+    bool next_item();
+    // Move past the next value without decoding it.
+    bool skip();
+    // Check that only whitespace is left.
+    bool finish();
+
+    bool failed() const;
+
+private:
+    // Reads the value of the current member into the field named by the current key.
+    struct FieldReader {
+        JsonReader & reader;
+        bool matched;
+
+        template<class F>
+        void operator()(const char * name, F & field) {
+            if (!matched && reader.m_key == name) {
+                matched = true;
+                reader.read(field);
+            }
+        }
+    };
+
+    std::unique_ptr<JsonParser> m_parser;
+    std::string m_key;
+    int m_depth;
+    bool m_first;   // Whether the current object or array has no members yet
+};
+
+/* parse_into(in, out, err)
+ *
+ * Decode the JSON document in into out with a JsonReader. Return false and set err on failure.
+ */
+template<class T>
+bool parse_into(const std::string & in, T & out, std::string & err) {
+    JsonReader reader(in, err);
+    return reader.read(out) && reader.finish();
+}
+
+/* JsonSink
+ *
+ * Destination for Json::dump(sink). write() is called with consecutive pieces of the output,
+ * each at most a few kilobytes long. Sinks do not report errors; check the underlying stream
+ * (ferror, std::ostream::fail) once the dump is done.
+ */
+class JsonSink {
+public:
+    virtual ~JsonSink() {}
+    virtual void write(const char * data, size_t len) = 0;
+};
+
+// Writes to a stdio stream. The FILE is not closed or flushed.
+class JsonFileSink final : public JsonSink {
+public:
+    explicit JsonFileSink(std::FILE * file) : m_file(file) {}
+    void write(const char * data, size_t len) override;
+private:
+    std::FILE * m_file;
+};
+
+// Writes to a std::ostream.
+class JsonStreamSink final : public JsonSink {
+public:
+    explicit JsonStreamSink(std::ostream & stream) : m_stream(stream) {}
+    void write(const char * data, size_t len) override;
+private:
+    std::ostream & m_stream;
+};
+
+// Passes every piece to a callback, e.g. one that writes to a file descriptor or socket.
+class JsonCallbackSink final : public JsonSink {
+public:
+    typedef std::function<void(const char * data, size_t len)> callback;
+    explicit JsonCallbackSink(callback cb) : m_callback(std::move(cb)) {}
+    void write(const char * data, size_t len) override { m_callback(data, len); }
+private:
+    callback m_callback;
+};
+
+/* JsonStreamParser
+ *
+ * Parses a stream of JSON values (concatenated or separated by whitespace, as accepted by
+ * Json::parse_multi) that arrives in arbitrary chunks. Each chunk is scanned once as it is
+ * fed, with the scanner's state carried across chunk boundaries, and each top-level value is
+ * parsed as soon as its last byte arrives. Only the bytes of the value in progress are kept.
+ *
+ *     JsonStreamParser parser;
+ *     while (size_t n = read(fd, buf, sizeof buf)) {
+ *         parser.feed(buf, n);
+ *         Json value;
+ *         while (parser.next(value))
+ *             handle(value);
+ *     }
+ *     parser.finish();
+ */
+class JsonStreamParser final {
+public:
+    JsonStreamParser();
+
+    // Append len bytes of input. Return false if the input so far is invalid.
+    bool feed(const char * data, size_t len);
+    // Signal the end of the input, completing a trailing top-level number or literal. Return
+    // false if the input was invalid or ended in the middle of a value.
+    bool finish();
+
+    // If a complete value is waiting, move it into out and return true.
+    bool next(Json & out);
+
+    bool failed() const { return !m_error.empty(); }
+    const std::string & error() const { return m_error; }
+
+private:
+    void scan();
+    void complete(size_t end);
+
+    std::string m_buffer;   // Unconsumed input, starting no later than the value in progress
+    size_t m_scanned;       // Bytes of m_buffer already seen by the scanner
+    size_t m_start;         // Offset of the value in progress, or npos
+    int m_depth;
+    bool m_in_string;
+    bool m_escaped;
+    std::deque<Json> m_values;
+    std::string m_error;
+};
+
+/* JsonAllocator
+ *
+ * Storage for the JsonValue nodes behind string, array and object values, for use with
+ * Json::set_allocator or Json::parse(in, err, allocator). Only the nodes themselves come from
+ * it: the elements of a Json::array or Json::object live in the std::vector or std::map, whose
+ * types are part of the API and so keep using std::allocator.
+ */
+class JsonAllocator {
+public:
+    virtual ~JsonAllocator() {}
+    // Return size bytes aligned to align, which is a power of two.
+    virtual void * allocate(size_t size, size_t align) = 0;
+    // Free memory returned by allocate(size, align).
+    virtual void deallocate(void * p, size_t size, size_t align) noexcept = 0;
+};
+
+/* JsonPoolAllocator
+ *
+ * Keeps freed nodes in per-thread free lists, one per 16-byte size class, and reuses them
+ * for later allocations on that thread, so that a steady stream of short-lived values does
+ * not contend on the global heap. A node freed on another thread joins that thread's lists.
+ * Each list holds a bounded number of nodes; the rest, and requests too large to pool, go
+ * to operator new and delete. It has no state of its own, so one instance can serve every
+ * thread.
+ */
+class JsonPoolAllocator final : public JsonAllocator {
+public:
+    void * allocate(size_t size, size_t align) override;
+    void deallocate(void * p, size_t size, size_t align) noexcept override;
+};
+
+/* Arena
+ *
+ * A monotonic allocator for JsonValue nodes. Allocation bumps a pointer through large blocks,
+ * freeing a node is a no-op, and the whole tree is released at once when the arena is
+ * destroyed. An Arena is not thread-safe, but the values it holds may be read from several
+ * threads at once like any other Json.
+ */
+class Arena final : public JsonAllocator {
+public:
+    explicit Arena(size_t block_size = 64 * 1024);
+    ~Arena();
+
+    Arena(const Arena &) = delete;
+    Arena & operator=(const Arena &) = delete;
+
+    // Return size bytes aligned to align, which must be a power of two.
+    void * allocate(size_t size, size_t align) override;
+    // Record that a node was freed. The memory is only reclaimed when the arena goes away.
+    void deallocate(void *, size_t, size_t) noexcept override { m_live--; }
+
+    // Total number of bytes handed out so far.
+    size_t bytes_used() const { return m_used; }
+
+private:
+    struct Block;
+
+    Block * m_head;
+    char * m_cur;
+    char * m_end;
+    size_t m_block_size;
+    size_t m_used;
+    size_t m_live;
 };
 
 // Internal class hierarchy - JsonValue objects are not exposed to users of this API.
-class JsonValue {
+class JsonValue : public detail::RefCounted {
 protected:
+#ifdef JSON11_NONATOMIC_REFCOUNT
+    friend void destroy_value(const JsonValue * value) noexcept;
+#endif
     friend class Json;
-    friend class JsonInt;
-    friend class JsonDouble;
+    friend class JsonString;
+    friend class JsonStringView;
+    friend class JsonArray;
+    friend class JsonObject;
+    friend class JsonLazyArray;
+    friend class JsonLazyObject;
+    friend class JsonFragment;
+    friend class JsonWriter;
     virtual Json::Type type() const = 0;
     virtual bool equals(const JsonValue * other) const = 0;
     virtual bool less(const JsonValue * other) const = 0;
-    virtual void dump(std::string &out) const = 0;
-    virtual double number_value() const;
-    virtual int int_value() const;
-    virtual bool bool_value() const;
+    virtual void dump(JsonWriter &out) const = 0;
+    virtual size_t serialized_size() const = 0;
+    // The serialized size of an array or object if it has already been computed, or 0.
+    virtual size_t known_size() const { return 0; }
+    virtual size_t hash() const;
+    // The hash of an array or object if it has already been computed, or 0.
+    virtual size_t known_hash() const { return 0; }
+    // Dump a node referenced by more than one Json, from the dump cache where possible.
+    virtual void dump_shared(JsonWriter &out) const { dump(out); }
     virtual const std::string &string_value() const;
     virtual const Json::array &array_items() const;
     virtual const Json &operator[](size_t i) const;
     virtual const Json::object &object_items() const;
     virtual const Json &operator[](const std::string &key) const;
+    // The items of an array or object node, to edit in place, or null if it can't be edited.
+    virtual Json::array *mutable_array() { return nullptr; }
+    virtual Json::object *mutable_object() { return nullptr; }
+    virtual std::string *mutable_string() { return nullptr; }
     virtual ~JsonValue() {}
 };
 
+#ifdef JSON11_NONATOMIC_REFCOUNT
+// Destroy a value whose count has dropped to zero, and free its storage.
+void destroy_value(const JsonValue * value) noexcept;
+
+inline void intrusive_add_ref(const JsonValue * value) noexcept {
+    value->m_refs++;
+}
+
+inline void intrusive_release(const JsonValue * value) noexcept {
+    if (--value->m_refs == 0)
+        destroy_value(value);
+}
+
+inline long intrusive_use_count(const JsonValue * value) noexcept {
+    return value->m_refs;
+}
+#endif
+
 } // namespace json11
+
+namespace std {
+template <>
+struct hash<json11::Json> {
+    size_t operator()(const json11::Json &value) const { return value.hash(); }
+};
+}
@@ -9,6 +9,10 @@
 #include <set>
 #include <unordered_map>
 #include <cstring>
+#include <limits>
+#include <functional>
+#include <cstddef>
+#include <thread>
 
 using namespace json11;
 using std::string;
@@ -24,6 +28,17 @@ CHECK_TRAIT(is_copy_assignable<Json>);
 CHECK_TRAIT(is_nothrow_move_assignable<Json>);
 CHECK_TRAIT(is_nothrow_destructible<Json>);
 
+// The inline scalars share storage with the value pointer; only the tag is extra.
+static_assert(sizeof(Json) <= sizeof(json11::detail::value_ptr) + sizeof(void *), "sizeof(Json)");
+
+// Allocates from the pool when it is destroyed at thread exit, after the thread's pool
+// cache is gone, and leaves the node for another thread to free.
+static JsonPoolAllocator exit_pool;
+static void * exit_node = nullptr;
+struct AllocatesAtThreadExit {
+    ~AllocatesAtThreadExit() { exit_node = exit_pool.allocate(20, alignof(std::max_align_t)); }
+};
+
 void parse_from_stdin() {
     string buf;
     string line;
@@ -74,6 +89,48 @@ static_assert(json11::detail::has_only_free_from_json<Quux>::value, "");
 static_assert(!json11::detail::has_only_free_from_json<Corge>::value, "");
 }
 
+// Decoded straight from JSON text by JsonReader.
+struct Endpoint {
+    string host;
+    int port = 0;
+    template <class V> void json_fields(V &v) { v("host", host); v("port", port); }
+};
+struct Service {
+    string name;
+    double weight = 1;
+    bool enabled = false;
+    std::vector<Endpoint> endpoints;
+    std::vector<int> ids;
+    Json extra;
+    template <class V> void json_fields(V &v) {
+        v("name", name); v("weight", weight); v("enabled", enabled);
+        v("endpoints", endpoints); v("ids", ids); v("extra", extra);
+    }
+};
+static_assert(json11::detail::has_json_fields<Service>::value, "");
+static_assert(!json11::detail::has_json_fields<Dummy::Foo>::value, "");
+
+// Records parse events as a compact string, stopping after a given number of them.
+struct EventRecorder : JsonHandler {
+    string events;
+    size_t limit = std::numeric_limits<size_t>::max();
+
+    bool record(const string &event) {
+        events += event + " ";
+        return --limit != 0;
+    }
+    bool on_null() override { return record("null"); }
+    bool on_bool(bool value) override { return record(value ? "true" : "false"); }
+    bool on_number(double value) override { return record("d" + Json(value).dump()); }
+    bool on_int(int value) override { return record("i" + Json(value).dump()); }
+    bool on_string(const string &value) override { return record("s:" + value); }
+    bool on_start_array() override { return record("["); }
+    bool on_end_array() override { return record("]"); }
+    bool on_start_object() override { return record("{"); }
+    bool on_key(const string &key) override { return record("k:" + key); }
+    bool on_end_object() override { return record("}"); }
+};
+
 int main(int argc, char **argv) {
     if (argc == 2 && argv[1] == string("--stdin")) {
         parse_from_stdin();
@@ -179,7 +236,598 @@ int main(int argc, char **argv) {
     Dummy::Quux quux = Json().as<Dummy::Quux>();
     Dummy::Corge cg = Json().as<Dummy::Corge>();
 
+    {
+        Arena arena(256);
+        Json arena_json = Json::parse(simple_test, err, arena);
+        assert(err.empty());
+        assert(arena_json == json);
+        assert(arena_json["k3"][1].int_value() == 123);
+        assert(arena.bytes_used() > 0);
+    }
+
+    {
+        // A process-wide allocator sees every node, from constructors and the parser alike.
+        struct CountingAllocator final : JsonAllocator {
+            JsonPoolAllocator pool;
+            size_t live = 0;
+            void * allocate(size_t size, size_t align) override {
+                live++;
+                return pool.allocate(size, align);
+            }
+            void deallocate(void * p, size_t size, size_t align) noexcept override {
+                live--;
+                pool.deallocate(p, size, align);
+            }
+        } counting;
+        Json::set_allocator(&counting);
+        {
+            Json constructed = Json::array { "a", Json::object { { "b", 1 } } };
+            assert(counting.live == 3);
+            Json parsed = Json::parse(simple_test, err);
+            assert(err.empty() && parsed == json && counting.live > 3);
+            for (int n = 0; n < 3; n++) {
+                Json::array many;
+                for (int k = 0; k < 100; k++)
+                    many.push_back(Json::array { string(k, 'x') });
+                assert(Json(many).array_items().size() == 100);
+            }
+        }
+        Json::set_allocator(nullptr);
+        assert(counting.live == 0);
+    }
+
+    {
+        // A node made after its thread's cache was destroyed still has its full class size
+        // when another thread's list hands it out again.
+        std::thread([] {
+            static thread_local AllocatesAtThreadExit at_exit;
+            (void)at_exit;
+            exit_pool.deallocate(exit_pool.allocate(20, alignof(std::max_align_t)), 20, 1);
+        }).join();
+        assert(exit_node);
+        exit_pool.deallocate(exit_node, 20, 1);
+        void *reused = exit_pool.allocate(32, alignof(std::max_align_t));
+        std::memset(reused, 0xab, 32);
+        exit_pool.deallocate(reused, 32, 1);
+    }
+
     Dummy::BazList baz_list = Json().as<Dummy::BazList>();
     Dummy::QuuxList quux_list = Json().as<Dummy::QuuxList>();
     Dummy::CorgeList corge_list = Json().as<Dummy::CorgeList>();
+
+    // Parsing from a buffer that is not NUL-terminated.
+    const char unterminated[] = { '[', '1', '2', ']', '3' };
+    Json bounded = Json::parse(unterminated, 4, err);
+    assert(err.empty());
+    assert(bounded == Json::array { 12 });
+    Json::parse(unterminated, 2, err);
+    assert(!err.empty());
+    err.clear();
+
+    const string view_test = R"({"plain": "abc", "escaped": "a\n\u00e9\ud83d\udca9", "n": 1.5})";
+    Json view = Json::parse_view(view_test.data(), view_test.size(), err);
+    assert(err.empty());
+    assert(view == Json::parse(view_test, err));
+    assert(view["plain"].string_value() == "abc");
+    assert(view["escaped"].string_value() == "a\n\xc3\xa9\xf0\x9f\x92\xa9");
+    assert(view["plain"] < Json("abd"));
+    assert(view.dump() == Json::parse(view_test, err).dump());
+
+    // Unescaped views dump straight from the input, before anything has decoded them.
+    const string raw_view_test = "[\"plain\", \"line\xe2\x80\xa8sep\", \"esc\\\"aped\"]";
+    Json raw_view = Json::parse_view(raw_view_test.data(), raw_view_test.size(), err);
+    assert(err.empty());
+    assert(raw_view.dump() == R"(["plain", "line\u2028sep", "esc\"aped"])");
+    assert(raw_view.dump() == Json::parse(raw_view_test, err).dump());
+
+    Json::parse_view("\"\\x\"", 4, err);
+    assert(!err.empty());
+    err.clear();
+
+    // parse_lazy reads like parse, and still rejects errors in subtrees it hasn't visited.
+    const string lazy_test = R"({"a": [1, {"b": "x\ny", "c": []}, [[2]]], "d": {"e": null}, "f": true})";
+    Json lazy = Json::parse_lazy(lazy_test.data(), lazy_test.size(), err);
+    assert(err.empty());
+    assert(lazy["a"][1]["b"].string_value() == "x\ny" && lazy["a"][2][0][0] == Json(2));
+    assert(lazy == Json::parse(lazy_test, err) && Json::parse(lazy_test, err) == lazy);
+    assert(lazy.dump() == Json::parse(lazy_test, err).dump());
+    assert(lazy.serialized_size() == lazy.dump().size() && !(lazy < lazy));
+    Json edited_lazy = lazy;
+    assert(edited_lazy.set_path("/d/e", 5, err) && edited_lazy["d"]["e"] == Json(5) && lazy["d"]["e"].is_null());
+    Json::parse_lazy("[1, [2, {\"x\": tru}]]", 20, err);
+    assert(err == "parse error: expected true, got tru}");
+    err.clear();
+    Json::parse_lazy("{\"a\": [1}", 10, err);
+    assert(!err.empty());
+    err.clear();
+    assert(Json::parse_lazy("  7 ", 4, err) == Json(7) && err.empty());
+    for (const string bad : { "[1,]", "{\"a\":1,}", "[[1,]]", "{\"a\":{\"b\":1,}}" }) {
+        string parse_err;
+        Json::parse(bad, parse_err);
+        assert(Json::parse_lazy(bad.data(), bad.size(), err).is_null() && err == parse_err && !err.empty());
+        err.clear();
+    }
+
+    // Runs of whitespace and plain characters either side of the vector width.
+    for (size_t n = 0; n < 40; n++) {
+        const string pad(n, ' ');
+        const string run(n, 'x');
+        Json keyed = Json::parse("{\"" + run + "\": 1, \"" + run + "\\u0041\": 2}", err);
+        assert(err.empty() && keyed[run] == Json(1) && keyed[run + "A"] == Json(2));
+        Json padded = Json::parse(pad + "[" + pad + "\"" + run + "\\t" + run + "\"" + pad + "]\n\t" + pad, err);
+        assert(err.empty());
+        assert(padded[0].string_value() == run + "\t" + run);
+
+        Json::parse("\"" + run + "\x01" + run + "\"", err);
+        assert(!err.empty());
+        err.clear();
+        Json::parse("\"" + run, err);
+        assert(err == "unexpected end of input in string");
+        err.clear();
+    }
+
+    // Escaping in dump, with the escaped byte either side of the vector width.
+    for (size_t n = 0; n < 40; n++) {
+        const string run(n, 'x');
+        assert(Json(run + "\"\\\n\x1f" + run).dump() == "\"" + run + "\\\"\\\\\\n\\u001f" + run + "\"");
+        assert(Json(run + "\xe2\x80\xa8\xe2\x80\xa9" + run).dump() == "\"" + run + "\\u2028\\u2029" + run + "\"");
+        assert(Json(run + "\xe2\x82\xac" + run).dump() == "\"" + run + "\xe2\x82\xac" + run + "\"");
+        assert(Json(run + "\xe2\x80").dump() == "\"" + run + "\xe2\x80\"");
+    }
+    string all_bytes;
+    for (int c = 1; c < 256; c++)
+        all_bytes += static_cast<char>(c);
+    assert(Json::parse(Json(all_bytes + all_bytes).dump(), err).string_value() == all_bytes + all_bytes);
+    assert(Json(string("\x00\b\x0b", 3)).dump() == "\"\\u0000\\b\\u000b\"");
+
+    // serialized_size() is exact, including for escapes and shared subtrees.
+    const Json shared_subtree = Json::object { { "k\n", Json::array { 1, 2.5, "\xe2\x80\xa8\x01" } } };
+    const Json sized = Json::array { shared_subtree, nullptr, true, false, -7, 1e100, Json::object {},
+                                     Json::array {}, "", all_bytes, shared_subtree };
+    assert(sized.serialized_size() == sized.dump().size());
+    assert(sized.serialized_size() == sized.dump().size());
+    assert(Json(all_bytes).serialized_size() == Json(all_bytes).dump().size());
+
+    // The dump cache only holds shared nodes, stays within its limit and empties with them.
+    Json::set_dump_cache_limit(1 << 20);
+    {
+        const Json flags = Json::object { { "flags", Json::array { "x", 1, false } } };
+        const string flags_dump = flags.dump();
+        assert(Json::dump_cache_size() == 0);
+        Json response = Json::object { { "a", flags }, { "b", Json::array { 1, 2 } } };
+        assert(response.dump() == "{\"a\": " + flags_dump + ", \"b\": [1, 2]}");
+        assert(Json::dump_cache_size() == flags_dump.size());
+        assert(response.dump() == "{\"a\": " + flags_dump + ", \"b\": [1, 2]}");
+        Json::set_dump_cache_limit(flags_dump.size() + 10);
+        const Json big = Json::array { all_bytes };
+        const Json big_response = Json::array { big, big };
+        assert(big_response.dump() == "[" + big.dump() + ", " + big.dump() + "]");
+        assert(Json::dump_cache_size() == flags_dump.size());
+    }
+    assert(Json::dump_cache_size() == 0);
+    Json::set_dump_cache_limit(0);
+
+    // Edits copy shared nodes on the way down and leave other copies alone.
+    {
+        Json doc = Json::object { { "servers", Json::array { Json::object { { "port", 80 } } } },
+                                  { "name", "a" } };
+        const Json before = doc;
+        assert(doc.set("name", "b") && doc["name"] == Json("b") && before["name"] == Json("a"));
+        assert(doc.set_path("/servers/0/port", 8080, err) && err.empty());
+        assert(doc["servers"][0]["port"] == Json(8080) && before["servers"][0]["port"] == Json(80));
+        assert(doc.set_path("/servers/-", "x", err) && doc["servers"][1] == Json("x"));
+        assert(doc.set_path("/a~1b~0", true, err) && doc["a/b~"] == Json(true));
+        assert(!doc.set_path("/missing/x", 1, err) && !err.empty());
+        err.clear();
+        assert(!doc.set_path("/servers/01", 1, err) && !err.empty());
+        err.clear();
+        assert(!doc.set_path("servers", 1, err) && !err.empty());
+        err.clear();
+        assert(doc.erase("name") && !doc.erase("name") && doc["name"].is_null());
+        Json list;
+        assert(list.push_back(1) && list.push_back(2) && list == Json(Json::array { 1, 2 }));
+        assert(list.erase(size_t(0)) && list == Json(Json::array { 2 }) && !list.erase(size_t(5)));
+        assert(!list.set("k", 1) && !Json(1).push_back(2));
+        const string cached = list.dump();
+        const Json keep = list;
+        list.push_back(3);
+        assert(keep.dump() == cached && list.dump() == "[2, 3]");
+        assert(list.serialized_size() == list.dump().size());
+        list.push_back(4);
+        assert(list.serialized_size() == list.dump().size() && list.dump() == "[2, 3, 4]");
+        // dump() reserves exactly once the size is known, and does not size the tree itself.
+        const Json sized = Json::array { string(100, 'a'), 1.5 };
+        assert(sized.serialized_size() == 109);
+        string reserved;
+        sized.dump(reserved);
+        assert(reserved.size() == 109 && reserved.capacity() == reserved.size());
+        Json holes = Json::object { { "n", nullptr } };
+        assert(!holes.set_path("/n/x", 1, err) && !err.empty() && holes["n"].is_null());
+        err.clear();
+        assert(holes.set_path("/n", 1, err) && holes["n"] == Json(1));
+        Json none;
+        assert(!none.set_path("/x", 1, err) && !err.empty() && none.is_null());
+        err.clear();
+        assert(none.set("x", 1) && none == Json(Json::object { { "x", 1 } }));
+        Json whole;
+        assert(whole.set_path("", Json::array { 1 }, err) && whole == Json(Json::array { 1 }));
+    }
+
+    // Compiled paths, in either syntax, for lookups, edits and partial parses.
+    {
+        const string text = R"({"a": [1, {"b c": "x", "d": [true]}], "a~b": 2, "z": [3, 4]})";
+        const Json doc = Json::parse(R"({"a": [1, {"b c": "x", "d": [true]}], "a~b": 2})", err);
+        const Json::Path pointer = Json::Path::compile("/a/1/b c", err);
+        const Json::Path jsonpath = Json::Path::compile("$.a[1]['b c']", err);
+        assert(err.empty() && pointer.size() == 3 && jsonpath.size() == 3);
+        assert(doc.at(pointer) == Json("x") && doc.at(jsonpath) == Json("x"));
+        assert(doc.at(Json::Path::compile("/a~0b", err)) == Json(2));
+        assert(doc.at(Json::Path::compile("/a/5", err)).is_null() && err.empty());
+        assert(doc.at(Json::Path()) == doc);
+        assert(Json::extract(text, jsonpath, err) == Json("x") && err.empty());
+        assert(Json::extract(text, Json::Path::compile("$.a[1].d", err), err) == Json(Json::array { true }));
+        assert(Json::extract(text, Json::Path::compile("/q", err), err).is_null() && err.empty());
+        const string bad = R"({"a": [1, {"b c": "x"}], "z": [3 4]})";
+        assert(Json::extract(bad, jsonpath, err).is_null() && !err.empty());
+        err.clear();
+        assert(Json::extract(text + " x", jsonpath, err).is_null() && !err.empty());
+        err.clear();
+        const string dup = R"({"a": {"b": 1}, "c": [{"d": 1}, {"d": 2, "d": [4]}], "a": {"b": 2, "b": [3]}})";
+        const Json dup_doc = Json::parse(dup, err);
+        for (const char *p : { "/a", "/a/b", "/a/b/0", "/c/1/d", "/c/0/d", "/zz", "/c/5" }) {
+            const Json::Path dup_path = Json::Path::compile(p, err);
+            assert(Json::extract(dup, dup_path, err) == dup_doc.at(dup_path) && err.empty());
+        }
+        assert(Json::extract(dup, Json::Path::compile("/a/b", err), err) == Json(Json::array { 3 }));
+        assert(Json::extract(text, Json::Path::compile("/a/2", err), err).is_null() && err.empty());
+        assert(Json::extract("[1,]", Json::Path::compile("/1", err), err).is_null() && !err.empty());
+        err.clear();
+        assert(Json::extract("{\"a\":1,}", Json::Path::compile("/a", err), err).is_null() && !err.empty());
+        err.clear();
+        const std::pair<const char *, const char *> trailing[] = {
+            { "[0,[1,],2]", "/0" }, { "{\"b\":[1,],\"a\":1}", "/a" }, { "{\"a\":1,}", "/a" },
+            { "[[1,]]", "/0/0" }, { "{\"b\":{\"c\":1,},\"a\":1}", "/a" },
+        };
+        for (const auto &t : trailing) {
+            string parse_err;
+            Json::parse(t.first, parse_err);
+            assert(Json::extract(t.first, Json::Path::compile(t.second, err), err).is_null());
+            assert(err == parse_err && !err.empty());
+            err.clear();
+        }
+        Json edited = doc;
+        assert(edited.set_path(jsonpath, "y", err) && edited.at(pointer) == Json("y") && doc.at(pointer) == Json("x"));
+        assert(Json::Path::compile("$.a[", err).size() == 0 && !err.empty());
+        err.clear();
+        assert(Json::Path::compile("$.a[-]", err).size() == 0 && !err.empty());
+        err.clear();
+    }
+
+    // Lookups by C string or pointer and length, without a std::string key.
+    {
+        const Json doc = Json::object { { "alpha", 1 }, { "beta", 2 } };
+        const char *key = "beta";
+        assert(doc["alpha"] == Json(1) && doc[key] == Json(2) && doc["gamma"].is_null());
+        assert(doc.get("alphabet", 5) == Json(1) && doc.get("al", 2).is_null());
+        assert(Json(Json::array { 7 })[0] == Json(7) && Json(3).get("a", 1).is_null());
+    }
+
+    // Hashes agree with ==, survive sharing and are recomputed after an edit.
+    {
+        Json a = Json::array { 1, "x", Json::object { { "k", 0.0 } } };
+        const Json b = Json::array { 1.0, "x", Json::object { { "k", -0.0 } } };
+        const Json shared = a;
+        assert(a == b && a.hash() == b.hash() && std::hash<Json>()(a) == a.hash());
+        assert(shared == a && !(shared < a));
+        a.push_back(2);
+        assert(a != b && shared == b && a.hash() != b.hash() && shared.hash() == b.hash());
+        std::unordered_map<Json, int> seen;
+        seen[b] = 1;
+        assert(seen.count(shared) == 1 && seen.count(a) == 0 && seen.count(Json("x")) == 0);
+    }
+
+#ifdef JSON11_STATS
+    // Parse and dump costs, counted per document.
+    {
+        Json::Stats stats;
+        const Json doc = Json::parse(R"({"a": [1, 2.5, true, null], "b": {"c": "x\ty"}})", err, stats);
+        assert(err.empty() && stats.values[Json::OBJECT] == 2 && stats.values[Json::ARRAY] == 1);
+        assert(stats.values[Json::NUMBER] == 2 && stats.values[Json::BOOL] == 1 && stats.values[Json::NUL] == 1);
+        assert(stats.values[Json::STRING] == 1 && stats.peak_depth == 2 && stats.unescaped_bytes == 3);
+        assert(stats.allocated_bytes > 0 && stats.parse_seconds >= 0);
+        string out;
+        doc.dump(out, stats);
+        assert(stats.dumped_bytes == out.size() && out == doc.dump());
+        Json::parse("[1,", err, stats);
+        assert(!err.empty() && stats.values[Json::NUMBER] == 3);
+        err.clear();
+    }
+#endif
+
+    // A reused parser gives the same results as Json::parse, document after document.
+    {
+        Json::Parser parser;
+        const string docs[] = { R"([[1, [2, 3]], ["a\nb", {"k": [4]}], []])", "[1,", R"({"s": "\u00e9"})", "[5] x" };
+        Json out[4];
+        string errors[4];
+        assert(parser.parse(docs, 4, out, errors) == 2);
+        assert(out[0] == Json::parse(docs[0], err) && out[0][1][0] == Json("a\nb"));
+        assert(out[1].is_null() && !errors[1].empty() && out[3].is_null() && !errors[3].empty());
+        assert(out[2]["s"] == Json("\xc3\xa9") && errors[2].empty());
+        assert(parser.parse("[[7], 8]", err) == Json(Json::array { Json::array { 7 }, 8 }) && err.empty());
+        Json::Parser moved = std::move(parser);
+        assert(moved.parse(docs[0], err) == out[0]);
+        for (const char *malformed : { "[1,]", "{\"b\":[1,],\"a\":1}", "[[1,]]", "[1 2]", "{\"a\":1,}", "[" }) {
+            string parse_err, parser_err;
+            Json::parse(malformed, parse_err);
+            assert(moved.parse(malformed, parser_err).is_null() && parser_err == parse_err && !parse_err.empty());
+        }
+    }
+
+    // Fragments dump their saved bytes and otherwise behave like the value they were made of.
+    {
+        const Json skeleton_value = Json::object { { "status", "ok" }, { "items", Json::array { 1, "a" } } };
+        static const Json skeleton = Json::fragment(skeleton_value);
+        const Json response = Json::object { { "header", skeleton }, { "count", 2 } };
+        assert(response.dump() == R"({"count": 2, "header": {"items": [1, "a"], "status": "ok"}})");
+        assert(skeleton.serialized_size() == skeleton_value.dump().size());
+        assert(skeleton == skeleton_value && skeleton_value == skeleton && !(skeleton < skeleton_value));
+        assert(skeleton.hash() == skeleton_value.hash() && skeleton["items"][1] == Json("a"));
+        Json edited = skeleton;
+        assert(edited.set("status", "error") && skeleton["status"] == Json("ok"));
+        assert(edited.dump() == R"({"items": [1, "a"], "status": "error"})");
+        assert(Json::fragment(3) == Json(3) && Json::fragment("s").dump() == "\"s\"");
+    }
+
+    // Parallel dumps match serial ones, however the items are split.
+    {
+        Json::array items;
+        Json::object fields;
+        for (int k = 0; k < 5000; k++) {
+            items.push_back(Json::array { k, "s\n" + std::to_string(k) });
+            fields["k" + std::to_string(k)] = k * 0.5;
+        }
+        const Json list = items, record = fields;
+        for (unsigned threads : { 1u, 3u, 0u }) {
+            string out = "x";
+            list.dump_parallel(out, threads);
+            assert(out == "x" + list.dump());
+            out.clear();
+            record.dump_parallel(out, threads);
+            assert(out == record.dump());
+        }
+        string out;
+        Json::fragment(list).dump_parallel(out, 4);
+        assert(out == list.dump());
+        out.clear();
+        Json(Json::array { 1, 2 }).dump_parallel(out, 4);
+        assert(out == "[1, 2]");
+    }
+
+    // Compact and indented layouts, straight from the tree.
+    {
+        const Json doc = Json::object { { "a", Json::array { 1, "x", Json::array {} } },
+                                        { "b", Json::object {} }, { "c", nullptr } };
+        assert(doc.dump(Json::DumpOptions()) == doc.dump());
+        assert(doc.dump(Json::DumpOptions(true)) == R"({"a":[1,"x",[]],"b":{},"c":null})");
+        assert(doc.dump(Json::DumpOptions(false, 2)) ==
+               "{\n  \"a\": [\n    1,\n    \"x\",\n    []\n  ],\n  \"b\": {},\n  \"c\": null\n}");
+        assert(doc.dump(Json::DumpOptions(true, 1)) == "{\n \"a\":[\n  1,\n  \"x\",\n  []\n ],\n \"b\":{},\n \"c\":null\n}");
+        assert(Json(3).dump(Json::DumpOptions(false, 4)) == "3");
+
+        // Saved and cached default-layout text is not used for other layouts.
+        Json::set_dump_cache_limit(1 << 20);
+        const Json shared = Json::fragment(doc), copy = shared;
+        assert(shared.dump() == doc.dump() && shared.dump(Json::DumpOptions(true)) == doc.dump(Json::DumpOptions(true)));
+        const Json list = Json::array { doc, doc };
+        assert(list.dump() == "[" + doc.dump() + ", " + doc.dump() + "]");
+        assert(list.dump(Json::DumpOptions(true)) == "[" + doc.dump(Json::DumpOptions(true)) + "," + doc.dump(Json::DumpOptions(true)) + "]");
+        std::ostringstream stream;
+        JsonStreamSink sink(stream);
+        list.dump(sink, Json::DumpOptions(false, 3));
+        assert(stream.str() == list.dump(Json::DumpOptions(false, 3)));
+        Json::set_dump_cache_limit(0);
+    }
+
+    // Typed decoding into arithmetic types, strings, containers and maps.
+    {
+        Json typed = Json::parse(R"({"nums": [1, 2.5, -3], "names": ["a", "b"], "flags": [true, false],
+                                     "nested": [[1], [2, 3]], "map": {"x": 1, "y": 2}})", err);
+        assert(err.empty());
+        assert(typed["nums"].as<std::vector<double>>() == (std::vector<double> { 1, 2.5, -3 }));
+        assert(typed["nums"].as<std::list<int>>() == (std::list<int> { 1, 2, -3 }));
+        assert(typed["nums"][1].as<float>() == 2.5f && typed["flags"][0].as<bool>());
+        assert(typed["flags"].as<std::vector<bool>>() == (std::vector<bool> { true, false }));
+        assert(typed["names"].as<std::set<string>>() == (std::set<string> { "a", "b" }));
+        assert(typed["names"][0].as<string>() == "a");
+        assert((typed["map"].as<std::map<string, int>>() == std::map<string, int> { { "x", 1 }, { "y", 2 } }));
+        assert((typed["nested"].as<std::vector<std::vector<int>>>()
+                == std::vector<std::vector<int>> { { 1 }, { 2, 3 } }));
+
+        // Decoding an rvalue moves from items nothing else shares, and copies the rest.
+        Json names = Json::array { string(100, 'n'), string(100, 'm') };
+        const Json shared_names = names;
+        assert(std::move(names).as<std::vector<string>>() == (std::vector<string> { string(100, 'n'), string(100, 'm') }));
+        assert(shared_names[0].string_value() == string(100, 'n'));
+        Json unique_names = Json::array { string(100, 'n') };
+        assert(std::move(unique_names).as<std::vector<string>>()[0] == string(100, 'n'));
+    }
+
+    // JsonReader decodes into structs, skipping what they don't list.
+    {
+        Service service;
+        assert(json11::parse_into(R"({"name": "api", "unknown": {"deep": [1, "x", {"y": null}]},
+            "endpoints": [{"host": "a", "port": 80}, {"port": 81, "host": "b", "zone": "z"}],
+            "enabled": true, "ids": [], "weight": null, "extra": {"k": [1]}})", service, err));
+        assert(err.empty() && service.name == "api" && service.enabled && service.weight == 1);
+        assert(service.endpoints.size() == 2 && service.endpoints[1].host == "b");
+        assert(service.endpoints[1].port == 81 && service.ids.empty());
+        assert(service.extra == Json(Json::object { { "k", Json::array { 1 } } }));
+
+        Service bad;
+        assert(!json11::parse_into(R"({"name": 5})", bad, err) && err == "expected string, got '5' (53)");
+        err.clear();
+        assert(!json11::parse_into(R"({"unknown": [1 2]})", bad, err) && !err.empty());
+        err.clear();
+        assert(!json11::parse_into(R"({"name": "x"} x)", bad, err) && !err.empty());
+        err.clear();
+        assert(!json11::parse_into(R"({"ids": [1,]})", bad, err) && !err.empty());
+        err.clear();
+        for (const char *skipped : { R"({"unknown": [1,]})", R"({"unknown": {"a": 1,}})",
+                                     R"({"unknown": [[1,]]})" }) {
+            assert(!json11::parse_into(skipped, bad, err) && !err.empty());
+            err.clear();
+        }
+
+        std::vector<std::vector<double>> matrix;
+        assert(json11::parse_into("[[1, 2], [], [3.5]]", matrix, err));
+        assert(matrix == (std::vector<std::vector<double>> { { 1, 2 }, {}, { 3.5 } }));
+    }
+
+    // CBOR round-trips every value and keeps ints and doubles apart.
+    const Json cbor_doc = Json::object {
+        { "ints", Json::array { 0, 23, 24, 255, 256, 65536, -1, -24, -25, std::numeric_limits<int>::min(),
+                                std::numeric_limits<int>::max() } },
+        { "doubles", Json::array { 0.0, 2.0, 0.1, -1.5e300, 1e-320, 3.25 } },
+        { "misc", Json::array { nullptr, true, false, "", all_bytes, Json::object {} } },
+    };
+    const string cbor = cbor_doc.dump_cbor();
+    Json cbor_parsed = Json::parse_cbor(cbor, err);
+    assert(err.empty() && cbor_parsed == cbor_doc);
+    assert(cbor_parsed["ints"][1].is_number() && cbor_parsed["ints"][1].dump() == "23");
+    assert(cbor_parsed["doubles"][1].dump() == "2" && cbor_parsed["doubles"][1].int_value() == 2);
+    assert(Json(2.0).dump_cbor() == string("\xfa\x40\x00\x00\x00", 5));
+    assert(Json(2).dump_cbor() == "\x02" && Json(-25).dump_cbor() == "\x38\x18");
+    assert(Json(Json::array { 1, "a" }).dump_cbor() == "\x82\x01\x61" "a");
+    assert(Json::parse_cbor(string("\xf9\x3c\x00", 3), err) == Json(1.0));
+    assert(Json::parse_cbor(string("\x1b\x00\x00\x00\x01\x00\x00\x00\x00", 9), err) == Json(4294967296.0));
+    assert(Json::parse_cbor("\xc1\x01", err) == Json(1) && err.empty());
+    Json::parse_cbor(cbor.substr(0, cbor.size() - 1), err);
+    assert(!err.empty());
+    err.clear();
+    Json::parse_cbor("\x9f\xff", err);
+    assert(err == "indefinite-length CBOR items are not supported");
+    err.clear();
+    Json::parse_cbor(cbor + '\0', err);
+    assert(!err.empty());
+    err.clear();
+
+    // Number formatting is shortest round-trip and number parsing is correctly rounded.
+    assert(Json(0.1).dump() == "0.1");
+    assert(Json(1.5e300).dump() == "1.5e+300");
+    assert(Json(-2.5e-7).dump() == "-2.5e-07");
+    assert(Json(123456.75).dump() == "123456.75");
+    assert(Json(1e16).dump() == "10000000000000000");
+    assert(Json(-0.0).dump() == "-0");
+    assert(Json(std::numeric_limits<int>::min()).dump() == "-2147483648");
+    const double round_trips[] = { 0.1, 1.0 / 3, 2.2250738585072014e-308, 4.9406564584124654e-324,
+                                   1.7976931348623157e308, 9007199254740993.0, -65.613616999999977 };
+    for (double value : round_trips) {
+        assert(Json::parse(Json(value).dump(), err).number_value() == value);
+        assert(std::strtod(Json(value).dump().c_str(), nullptr) == value);
+    }
+    assert(Json::parse("1.5e3", err).number_value() == 1500);
+    assert(Json::parse("-0.000123", err).number_value() == -0.000123);
+    assert(Json::parse("123456789012345678901234567890", err).number_value() == 1.2345678901234568e+29);
+    assert(Json::parse("2.2250738585072011e-308", err).number_value() == 2.2250738585072011e-308);
+    assert(Json::parse("1e400", err).number_value() == std::numeric_limits<double>::infinity());
+    assert(err.empty());
+
+    // Objects iterate in key order, whichever backend holds them; the last duplicate parsed wins.
+    Json unordered = Json::parse(R"({"b": 1, "c": 2, "a": 3, "b": 4})", err);
+    assert(unordered.dump() == R"({"a": 3, "b": 4, "c": 2})");
+    assert(unordered.object_items().size() == 3);
+    assert(unordered["c"] == Json(2));
+    assert(unordered["d"].is_null());
+
+    flat_map<string, int> flat { { "y", 1 }, { "x", 2 }, { "y", 3 } };
+    assert(flat.size() == 2 && flat.begin()->first == "x" && flat["y"] == 1);
+    flat["w"] = 4;
+    assert(flat.begin()->first == "w" && flat.count("w") == 1);
+    assert(flat.erase("x") == 1 && flat.find("x") == flat.end());
+
+    // Scalars are stored inline but keep their int/double distinction.
+    assert(Json(7).int_value() == 7 && Json(7).number_value() == 7.0);
+    assert(Json(7.9).int_value() == 7);
+    assert(Json(false) < Json(true) && Json(1) < Json(1.5) && !(Json() < Json(nullptr)));
+    assert(Json::parse("[1, 2.5, true, null]", err) == Json(Json::array { 1, 2.5, true, nullptr }));
+    assert(Json(3).string_value().empty() && Json(true).array_items().empty());
+    assert(Json(3)["k"].is_null() && Json(3)[0].is_null());
+
+    // Event parsing reports the same structure without building it, and can stop early.
+    EventRecorder recorder;
+    assert(Json::parse(R"({"a": [1, 2.5, "x\ty"], "b": {}, "c": null, "d": [true, false]})", recorder, err));
+    assert(recorder.events == "{ k:a [ i1 d2.5 s:x\ty ] k:b { } k:c null k:d [ true false ] } ");
+    EventRecorder stopper;
+    stopper.limit = 3;
+    assert(!Json::parse("[[1, 2], 3]", stopper, err) && err.empty());
+    assert(stopper.events == "[ [ i1 ");
+    EventRecorder broken;
+    assert(!Json::parse("[1, 2", broken, err) && !err.empty());
+    err.clear();
+    JsonHandler ignore_all;
+    assert(Json::parse(simple_test, ignore_all, err) && err.empty());
+
+    // Chunked input gives the same values as parse_multi, wherever the chunks are split.
+    const string stream_test = R"({"a": "x\"}y", "b": [1, {"c": "]"}]} 12 [true]"s\\"-3.5e2 null{})";
+    const std::vector<Json> expected_values = Json::parse_multi(stream_test, err);
+    assert(err.empty() && expected_values.size() == 7);
+    for (size_t chunk = 1; chunk <= stream_test.size(); chunk++) {
+        JsonStreamParser stream;
+        std::vector<Json> values;
+        for (size_t pos = 0; pos < stream_test.size(); pos += chunk) {
+            assert(stream.feed(stream_test.data() + pos, std::min(chunk, stream_test.size() - pos)));
+            Json value;
+            while (stream.next(value))
+                values.push_back(value);
+        }
+        assert(stream.finish());
+        Json value;
+        while (stream.next(value))
+            values.push_back(value);
+        assert(values == expected_values);
+    }
+    JsonStreamParser truncated_stream;
+    assert(truncated_stream.feed("[1, 2", 5) && !truncated_stream.finish());
+    JsonStreamParser bad_stream;
+    assert(!bad_stream.feed("[1, 2} ", 7) && !bad_stream.error().empty());
+
+    // Parallel NDJSON parsing matches a serial parse_multi, including where it fails.
+    string ndjson;
+    for (int n = 0; n < 20000; n++)
+        ndjson += Json(Json::object { { "id", n }, { "name", "record" } }).dump() + "\n";
+    const std::vector<Json> serial = Json::parse_multi(ndjson, err);
+    assert(err.empty() && serial.size() == 20000);
+    assert(Json::parse_ndjson(ndjson, err, 4) == serial && err.empty());
+    Json::executor inline_executor = [](std::function<void()> task) { task(); };
+    assert(Json::parse_ndjson(ndjson, err, inline_executor, 7) == serial && err.empty());
+
+    string broken_ndjson = ndjson;
+    broken_ndjson[broken_ndjson.size() / 3] = 1;
+    broken_ndjson[broken_ndjson.size() * 2 / 3] = 1;
+    string serial_err;
+    const std::vector<Json> serial_partial = Json::parse_multi(broken_ndjson, serial_err);
+    assert(Json::parse_ndjson(broken_ndjson, err, 4) == serial_partial);
+    assert(!err.empty() && err == serial_err);
+    err.clear();
+
+    // Dumping to a sink produces the same bytes as dump(), across many buffer refills.
+    const Json big_array = Json(serial);
+    const string big_dump = big_array.dump();
+    std::ostringstream sink_stream;
+    JsonStreamSink stream_sink(sink_stream);
+    big_array.dump(stream_sink);
+    assert(sink_stream.str() == big_dump);
+    string callback_out;
+    size_t callback_calls = 0;
+    JsonCallbackSink callback_sink([&](const char *data, size_t len) {
+        callback_out.append(data, len);
+        callback_calls++;
+    });
+    big_array.dump(callback_sink);
+    assert(callback_out == big_dump && callback_calls > 1);
+    const Json long_string = string(100000, 'x');
+    callback_out.clear();
+    long_string.dump(callback_sink);
+    assert(callback_out == long_string.dump());
 }